@@ -0,0 +1,72 @@
+// Benchmark of ActorSpatialIndex on synthetic actor clouds: a radius query through the grid (rebuilt every
+// "frame", like the actor snapshot does) against the full distance scan it replaces, and a check that the grid
+// returns every point within range.
+
+#include "ActorSpatialIndex.h"
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace _ts_SKSEFunctions;
+
+int main() {
+	std::mt19937 random(12345);
+	// actors spread over the 5x5 loaded cells around the player at the origin
+	std::uniform_real_distribution<float> coordinate(-2.5f * ActorSpatialIndex::kCellSize, 2.5f * ActorSpatialIndex::kCellSize);
+	const float radius = 3000.0f;
+
+	std::printf("%8s %14s %14s %14s %10s\n", "actors", "scan ns", "build ns", "query ns", "missing");
+
+	int result = 0;
+	ActorSpatialIndex index;
+	std::vector<std::uint32_t> candidates;
+	for (const std::size_t count : { 100, 1000, 10000 }) {
+		std::vector<float> x(count), y(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			x[i] = coordinate(random);
+			y[i] = coordinate(random);
+		}
+
+		const std::size_t iterations = std::max<std::size_t>(1, 2000000 / count);
+		const double scanTime = Bench::MeasureNanoseconds([&] {
+			std::size_t inRange = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				inRange += x[i] * x[i] + y[i] * y[i] <= radius * radius;
+			}
+			Bench::DoNotOptimize(inRange);
+		}, iterations);
+		const double buildTime = Bench::MeasureNanoseconds([&] {
+			index.Build(x, y);
+			Bench::DoNotOptimize(index.GetBucketCount());
+		}, iterations);
+		const double queryTime = Bench::MeasureNanoseconds([&] {
+			candidates.clear();
+			index.QueryRadius(0.0f, 0.0f, radius, candidates);
+			std::size_t inRange = 0;
+			for (const auto i : candidates) {
+				inRange += x[i] * x[i] + y[i] * y[i] <= radius * radius;
+			}
+			Bench::DoNotOptimize(inRange);
+		}, iterations);
+
+		candidates.clear();
+		index.QueryRadius(0.0f, 0.0f, radius, candidates);
+		std::sort(candidates.begin(), candidates.end());
+		std::size_t missing = 0;
+		for (std::uint32_t i = 0; i < count; ++i) {
+			if (x[i] * x[i] + y[i] * y[i] <= radius * radius && !std::binary_search(candidates.begin(), candidates.end(), i)) {
+				++missing;
+			}
+		}
+
+		std::printf("%8zu %14.1f %14.1f %14.1f %10zu\n", count, scanTime, buildTime, queryTime, missing);
+		if (missing != 0) {
+			result = 1;
+		}
+	}
+	return result;
+}
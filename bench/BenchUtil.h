@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// Minimal timing helpers shared by the off-game benchmarks
+namespace _ts_SKSEFunctions::Bench {
+	// keeps a result alive, so the compiler can't drop the benchmarked work
+	template <class T>
+	inline void DoNotOptimize(const T& a_value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		static volatile const void* sink;
+		sink = &a_value;
+#else
+		asm volatile("" : : "r,m"(a_value) : "memory");
+#endif
+	}
+
+	// returns the median time of one call of a_func in nanoseconds, over a_runs runs of a_iterations calls each
+	template <class Func>
+	double MeasureNanoseconds(Func&& a_func, std::size_t a_iterations, std::size_t a_runs = 7) {
+		std::vector<double> times;
+		times.reserve(a_runs);
+		for (std::size_t run = 0; run < a_runs; ++run) {
+			const auto start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < a_iterations; ++i) {
+				a_func();
+			}
+			const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			times.push_back(elapsed / static_cast<double>(a_iterations));
+		}
+		std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+		return times[times.size() / 2];
+	}
+}
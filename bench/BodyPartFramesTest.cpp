@@ -0,0 +1,225 @@
+// Off-game test of the body part frame mappings behind BodyPartFrameTable: the built-in table must reproduce the
+// head and torso frames GetBodyPartCoordinateFrame() used to hard-code, and malformed INI data must be skipped line by
+// line without losing the valid mappings around it.
+
+#include "BodyPartFrames.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace _ts_SKSEFunctions;
+
+namespace {
+	constexpr std::size_t kTorso = 0;
+	constexpr std::size_t kHead = 1;
+	constexpr std::size_t kEye = 2;
+
+	using Vector = std::array<float, 3>;
+
+	struct Frame
+	{
+		Vector forward, right, up;
+
+		bool operator==(const Frame&) const = default;
+	};
+
+	Vector Negate(const Vector& a_vector) { return { -a_vector[0], -a_vector[1], -a_vector[2] }; }
+
+	bool Contains(std::initializer_list<std::string_view> a_list, std::string_view a_editorID)
+	{
+		return std::find(a_list.begin(), a_list.end(), a_editorID) != a_list.end();
+	}
+
+	// the frames GetBodyPartCoordinateFrame() hard-coded before the table, x/y/z are the rotation matrix columns
+	Frame OldFrame(std::string_view a_editorID, std::size_t a_limb, const Vector& x, const Vector& y, const Vector& z)
+	{
+		if (a_limb == kHead) {
+			if (Contains({ "AtronachFlameBodyPartData", "AtronachFrostBodyPartData", "AtronachStormBodyPartData", "BenthicLurkerBodyPartData",
+					"DefaultBodyPartData", "DLC2NetchBodyPartData", "DLC2RieklingBodyPartData", "DragonPriestBodyPartData", "DraugrBodyPartData",
+					"DwarvenBallistaCenturionBodyPartData", "DwarvenSpiderPartData", "FalmerBodyPartData", "GargoyleBodyPartData",
+					"GiantBodyPartData", "HagravenBodyPartData", "MudcrabPartData", "SprigganBodyPartData", "TrollBodyPartData",
+					"WerewolfBeastBodyPartData", "WispBodyPartData" }, a_editorID)) {
+				return { y, x, z };
+			}
+			if (Contains({ "DLC2HMDaedraPartData", "DLC2MountedRieklingBodyPartData", "DLC2ScribBodyPartData", "DwarvenSphereCenturionBodyPartData",
+					"FrostbiteSpiderPartData", "SlaughterfishBodyPartData", "WitchlightBodyPartData" }, a_editorID)) {
+				return { y, z, x };
+			}
+			if (Contains({ "BearBodyPartData", "ChaurusBodyPartData", "CowBodyPartData", "DLC2DragonBodyPartData", "DragonBodyPartData",
+					"MammothBodyPartData", "SabreCatBodyPartData" }, a_editorID)) {
+				return { x, Negate(z), Negate(y) };
+			}
+			if (Contains({ "ChaurusFlyerBodyPartData", "ChickenBodyPartData", "DeerBodyPartData", "DogBodyPartData",
+					"DwarvenSteamCenturionBodyPartData", "GoatBodyPartData", "HareBodyPartData", "HorseBodyPartData", "SkeeverBodyPartData" },
+					a_editorID)) {
+				return { z, x, Negate(y) };
+			}
+			if (a_editorID == "IceWraithBodyPartData") {
+				return { Negate(x), y, z };
+			}
+			if (a_editorID == "HorkerBodyPartData") {
+				return { Negate(y), x, Negate(z) };
+			}
+		} else if (a_limb == kTorso) {
+			if (Contains({ "AtronachFlameBodyPartData", "AtronachFrostBodyPartData", "AtronachStormBodyPartData", "BenthicLurkerBodyPartData",
+					"DefaultBodyPartData", "DLC2NetchBodyPartData", "DLC2RieklingBodyPartData", "DragonPriestBodyPartData", "DraugrBodyPartData",
+					"DwarvenBallistaCenturionBodyPartData", "DwarvenSpiderPartData", "DwarvenSteamCenturionBodyPartData", "FalmerBodyPartData",
+					"GargoyleBodyPartData", "GiantBodyPartData", "HagravenBodyPartData", "MudcrabPartData", "SprigganBodyPartData",
+					"TrollBodyPartData", "WerewolfBeastBodyPartData", "WitchlightBodyPartData" }, a_editorID)) {
+				return { y, x, z };
+			}
+			if (Contains({ "DLC2DragonBodyPartData", "DLC2HMDaedraPartData", "DLC2MountedRieklingBodyPartData", "DragonBodyPartData",
+					"SlaughterfishBodyPartData", "WispBodyPartData" }, a_editorID)) {
+				return { y, z, x };
+			}
+			if (Contains({ "BearBodyPartData", "ChaurusBodyPartData", "CowBodyPartData", "DLC2ScribBodyPartData",
+					"DwarvenSphereCenturionBodyPartData", "MammothBodyPartData", "SabreCatBodyPartData" }, a_editorID)) {
+				return { x, Negate(z), Negate(y) };
+			}
+			if (Contains({ "ChaurusFlyerBodyPartData", "ChickenBodyPartData", "DeerBodyPartData", "DogBodyPartData", "HareBodyPartData",
+					"HorkerBodyPartData", "HorseBodyPartData", "GoatBodyPartData", "SkeeverBodyPartData" }, a_editorID)) {
+				return { z, x, Negate(y) };
+			}
+			if (a_editorID == "IceWraithBodyPartData") {
+				return { Negate(x), y, z };
+			}
+			if (a_editorID == "FrostbiteSpiderPartData") {
+				return { Negate(x), z, y };
+			}
+		}
+		// unhandled editor IDs and other limbs use the default frame
+		return { y, x, z };
+	}
+
+	// the frame GetBodyPartCoordinateFrame() gets from the table, the default mapping if there is none
+	Frame NewFrame(const BodyPartFrameMappings& a_mappings, std::string_view a_editorID, std::size_t a_limb, const float* a_rotation)
+	{
+		BodyPartAxisMapping mapping;
+		if (const auto* limbs = a_mappings.Find(a_editorID); limbs && (*limbs)[a_limb]) {
+			mapping = *(*limbs)[a_limb];
+		}
+		Frame frame;
+		mapping.Apply(a_rotation, frame.forward.data(), frame.right.data(), frame.up.data());
+		return frame;
+	}
+
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_what)
+	{
+		if (!a_condition) {
+			std::printf("FAILED: %s\n", a_what);
+			++failures;
+		}
+	}
+
+	void TestDefaultTable()
+	{
+		BodyPartFrameMappings mappings;
+		std::vector<std::string> warnings;
+		const std::size_t count = mappings.Parse(kDefaultBodyPartFrames, &warnings);
+		Check(warnings.empty(), "default table: parses without warnings");
+		Check(count == 90, "default table: all mappings are read");
+
+		// row-major, every entry distinct, so any swapped or negated column shows
+		const float rotation[9] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f };
+		const Vector x{ 1.0f, 4.0f, 7.0f };
+		const Vector y{ 2.0f, 5.0f, 8.0f };
+		const Vector z{ 3.0f, 6.0f, 9.0f };
+
+		const std::string_view editorIDs[] = { "AtronachFlameBodyPartData", "AtronachFrostBodyPartData", "AtronachStormBodyPartData",
+			"BearBodyPartData", "BenthicLurkerBodyPartData", "ChaurusBodyPartData", "ChaurusFlyerBodyPartData", "ChickenBodyPartData",
+			"CowBodyPartData", "DeerBodyPartData", "DefaultBodyPartData", "DLC2DragonBodyPartData", "DLC2HMDaedraPartData",
+			"DLC2MountedRieklingBodyPartData", "DLC2NetchBodyPartData", "DLC2RieklingBodyPartData", "DLC2ScribBodyPartData", "DogBodyPartData",
+			"DragonBodyPartData", "DragonPriestBodyPartData", "DraugrBodyPartData", "DwarvenBallistaCenturionBodyPartData",
+			"DwarvenSphereCenturionBodyPartData", "DwarvenSpiderPartData", "DwarvenSteamCenturionBodyPartData", "FalmerBodyPartData",
+			"FrostbiteSpiderPartData", "GargoyleBodyPartData", "GiantBodyPartData", "GoatBodyPartData", "HagravenBodyPartData",
+			"HareBodyPartData", "HorkerBodyPartData", "HorseBodyPartData", "IceWraithBodyPartData", "MammothBodyPartData", "MudcrabPartData",
+			"SabreCatBodyPartData", "SkeeverBodyPartData", "SlaughterfishBodyPartData", "SprigganBodyPartData", "TrollBodyPartData",
+			"WerewolfBeastBodyPartData", "WispBodyPartData", "WitchlightBodyPartData", "ModAddedCreatureBodyPartData" };
+		for (const auto editorID : editorIDs) {
+			for (std::size_t limb = 0; limb < kBodyPartLimbNames.size(); ++limb) {
+				if (NewFrame(mappings, editorID, limb, rotation) != OldFrame(editorID, limb, x, y, z)) {
+					std::printf("  %.*s [%.*s]\n", static_cast<int>(editorID.size()), editorID.data(),
+						static_cast<int>(kBodyPartLimbNames[limb].size()), kBodyPartLimbNames[limb].data());
+					Check(false, "default table: frame matches the old hard-coded one");
+				}
+			}
+		}
+
+		// editor IDs are case-insensitive
+		Check(mappings.Find("horsebodypartdata") == mappings.Find("HorseBodyPartData"), "default table: case-insensitive editor IDs");
+	}
+
+	void TestMalformedLines()
+	{
+		BodyPartFrameMappings mappings;
+		std::vector<std::string> warnings;
+		const std::size_t count = mappings.Parse(R"(
+OrphanBodyPartData = +Y +X +Z
+[Head
+LostBodyPartData = +Y +X +Z
+[Head]
+this line has no separator
+ = +Y +X +Z
+GoodBodyPartData = +X -Z -Y     ; inline comment
+[Tail]
+TailBodyPartData = +Y +X +Z
+[eye]
+EyeBodyPartData = -Z +X +Y
+)", &warnings);
+
+		Check(count == 2, "malformed lines: the valid mappings around them are read");
+		// orphan key, unterminated section, missing separator, missing key, unknown section; keys of the bad sections aren't warned
+		Check(warnings.size() == 5, "malformed lines: each is reported once");
+		Check(mappings.Find("OrphanBodyPartData") == nullptr, "malformed lines: keys outside of a section are skipped");
+		Check(mappings.Find("LostBodyPartData") == nullptr, "malformed lines: keys of an unterminated section are skipped");
+		Check(mappings.Find("TailBodyPartData") == nullptr, "malformed lines: keys of an unknown section are skipped");
+
+		const auto* good = mappings.Find("GoodBodyPartData");
+		Check(good && (*good)[kHead] && (*good)[kHead]->ToString() == "+X -Z -Y", "malformed lines: inline comments are stripped");
+		const auto* eye = mappings.Find("EyeBodyPartData");
+		Check(eye && (*eye)[kEye] && (*eye)[kEye]->ToString() == "-Z +X +Y", "malformed lines: section names are case-insensitive");
+	}
+
+	void TestInvalidMappings()
+	{
+		Check(!BodyPartAxisMapping::Parse("+Y +X"), "missing axis: two axes are rejected");
+		Check(!BodyPartAxisMapping::Parse(""), "missing axis: an empty value is rejected");
+		Check(!BodyPartAxisMapping::Parse("+Y +X -"), "missing axis: a trailing sign is rejected");
+		Check(!BodyPartAxisMapping::Parse("+Y +Y +Z"), "duplicate axis is rejected");
+		Check(!BodyPartAxisMapping::Parse("+Y +X +W"), "unknown axis is rejected");
+		Check(!BodyPartAxisMapping::Parse("+Y +X +Z +X"), "a fourth axis is rejected");
+		const auto mapping = BodyPartAxisMapping::Parse("x, -z, -Y");
+		Check(mapping && mapping->ToString() == "+X -Z -Y", "lower case axes, commas and implicit signs are accepted");
+
+		BodyPartFrameMappings mappings;
+		std::vector<std::string> warnings;
+		const std::size_t count = mappings.Parse("[Torso]\nMissingAxisBodyPartData = +Y +X\nDefaultBodyPartData = +Y +X +Z\n", &warnings);
+		Check(count == 1 && warnings.size() == 1, "missing axis: the line is skipped and reported");
+		Check(warnings.size() == 1 && warnings[0].find("line 2") != std::string::npos, "missing axis: the warning names the line");
+		Check(mappings.Find("MissingAxisBodyPartData") == nullptr, "missing axis: no mapping is added");
+
+		// an override replaces the built-in mapping of its limb only
+		mappings.Parse(kDefaultBodyPartFrames);
+		mappings.Parse("[Head]\nHorseBodyPartData = +Y +X +Z\n");
+		const auto* horse = mappings.Find("HorseBodyPartData");
+		Check(horse && (*horse)[kHead] && (*horse)[kHead]->ToString() == "+Y +X +Z", "override: the limb's mapping is replaced");
+		Check(horse && (*horse)[kTorso] && (*horse)[kTorso]->ToString() == "+Z +X -Y", "override: the other limbs are kept");
+	}
+}
+
+int main() {
+	TestDefaultTable();
+	TestMalformedLines();
+	TestInvalidMappings();
+
+	if (failures == 0) {
+		std::printf("BodyPartFramesTest passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
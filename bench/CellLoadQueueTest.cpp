@@ -0,0 +1,207 @@
+// Off-game test of the load scheduling behind CellPrefetcher: a fake loader with a simulated clock checks that the
+// requests are loaded in priority order, that the per-frame budget counts failed loads as well, and that Reset()
+// forgets the prefetched cells.
+
+#include "CellLoadQueue.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace _ts_SKSEFunctions;
+
+namespace {
+	struct Worldspace
+	{
+		std::uint32_t formID;
+	};
+
+	using Queue = CellLoadQueue<Worldspace>;
+
+	// every load takes loadTime_us of simulated time, the cells in failing don't load
+	class FakeLoader : public Queue::ICellLoader
+	{
+	public:
+		bool IsLoaded(Worldspace*, std::int16_t a_cellX, std::int16_t a_cellY) override { return loaded.contains({ a_cellX, a_cellY }); }
+
+		bool Load(Worldspace*, std::int16_t a_cellX, std::int16_t a_cellY) override
+		{
+			time_us += loadTime_us;
+			order.emplace_back(a_cellX, a_cellY);
+			if (failing.contains({ a_cellX, a_cellY })) {
+				return false;
+			}
+			loaded.insert({ a_cellX, a_cellY });
+			return true;
+		}
+
+		void BeginLoads() override { ++frames; }
+
+		std::uint64_t GetTime_us() override { return time_us; }
+
+		std::uint64_t time_us = 0;
+		std::uint64_t loadTime_us = 1000;
+		std::size_t frames = 0;
+		std::set<std::pair<std::int16_t, std::int16_t>> loaded;
+		std::set<std::pair<std::int16_t, std::int16_t>> failing;
+		std::vector<std::pair<std::int16_t, std::int16_t>> order;
+	};
+
+	std::uint64_t Key(std::int16_t a_cellX, std::int16_t a_cellY)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint16_t>(a_cellX)) << 16) | static_cast<std::uint16_t>(a_cellY);
+	}
+
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_what)
+	{
+		if (!a_condition) {
+			std::printf("FAILED: %s\n", a_what);
+			++failures;
+		}
+	}
+
+	// requests cells (i, 0) with the priorities given, in that order
+	void Request(Queue& a_queue, Worldspace& a_worldspace, const std::vector<float>& a_priorities, std::size_t a_maxSize = 32)
+	{
+		a_queue.SetRequests([&](Queue::Builder& a_requests) {
+			for (std::size_t i = 0; i < a_priorities.size(); ++i) {
+				const auto x = static_cast<std::int16_t>(i);
+				a_requests.Add(&a_worldspace, Key(x, 0), x, 0, a_priorities[i]);
+			}
+		}, a_maxSize);
+	}
+
+	void TestPriorityOrder()
+	{
+		Worldspace worldspace{ 0x3C };
+		auto loader = std::make_shared<FakeLoader>();
+		Queue queue(loader);
+
+		Request(queue, worldspace, { 3.0f, 0.5f, 2.0f, 1.0f });
+		const std::size_t loaded = queue.Process(1000000);
+		Check(loaded == 4, "priority order: all requests load within a large budget");
+		const std::vector<std::pair<std::int16_t, std::int16_t>> expected{ { 1, 0 }, { 3, 0 }, { 2, 0 }, { 0, 0 } };
+		Check(loader->order == expected, "priority order: most urgent request first");
+	}
+
+	void TestDuplicatesAndTrim()
+	{
+		Worldspace worldspace{ 0x3C };
+		auto loader = std::make_shared<FakeLoader>();
+		Queue queue(loader);
+
+		// cell (0, 0) is added twice and keeps the lower priority, the two least urgent cells are trimmed
+		queue.SetRequests([&](Queue::Builder& a_requests) {
+			a_requests.Add(&worldspace, Key(0, 0), 0, 0, 5.0f);
+			a_requests.Add(&worldspace, Key(1, 0), 1, 0, 1.0f);
+			a_requests.Add(&worldspace, Key(2, 0), 2, 0, 4.0f);
+			a_requests.Add(&worldspace, Key(3, 0), 3, 0, 6.0f);
+			a_requests.Add(&worldspace, Key(0, 0), 0, 0, 0.5f);
+		}, 2);
+		Check(queue.GetSize() == 2, "trim: queue keeps maxSize requests");
+		Check(queue.GetStats().predictions == 4, "duplicates: a cell is only queued once");
+
+		queue.Process(1000000);
+		const std::vector<std::pair<std::int16_t, std::int16_t>> expected{ { 0, 0 }, { 1, 0 } };
+		Check(loader->order == expected, "trim: the most urgent requests are kept, duplicates at their lowest priority");
+	}
+
+	void TestBudget()
+	{
+		Worldspace worldspace{ 0x3C };
+		auto loader = std::make_shared<FakeLoader>();
+		Queue queue(loader);
+
+		// 1 ms per load and a 2.5 ms budget: three loads per frame (the budget is checked before each load)
+		Request(queue, worldspace, { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f });
+		Check(queue.Process(2500) == 3, "budget: loads stop when the budget is used up");
+		Check(queue.GetSize() == 4, "budget: the remaining requests stay queued");
+		Check(queue.GetStats().budgetExhausted == 1, "budget: the exhausted frame is counted");
+		Check(queue.Process(2500) == 3, "budget: the next frame continues with the remaining requests");
+		Check(queue.Process(2500) == 1, "budget: the last request loads");
+		Check(queue.GetSize() == 0 && queue.Process(2500) == 0, "budget: an empty queue loads nothing");
+
+		// a budget smaller than one load still loads one cell per frame
+		Request(queue, worldspace, { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f });
+		Check(queue.Process(10) == 1, "budget: at least one load per frame");
+	}
+
+	void TestBudgetWithFailedLoads()
+	{
+		Worldspace worldspace{ 0x3C };
+		auto loader = std::make_shared<FakeLoader>();
+		Queue queue(loader);
+
+		// failed loads take time as well and must use up the budget like successful ones
+		for (std::int16_t x = 0; x < 8; ++x) {
+			loader->failing.insert({ x, 0 });
+		}
+		Request(queue, worldspace, { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f });
+		Check(queue.Process(2500) == 0, "failed loads: nothing loaded");
+		Check(loader->order.size() == 3, "failed loads: attempts are bounded by the budget");
+		const auto stats = queue.GetStats();
+		Check(stats.loads == 3 && stats.failedLoads == 3, "failed loads: attempts are counted");
+		Check(stats.budgetExhausted == 1, "failed loads: the exhausted frame is counted");
+	}
+
+	void TestPrefetchedAndReset()
+	{
+		Worldspace worldspace{ 0x3C };
+		auto loader = std::make_shared<FakeLoader>();
+		Queue queue(loader);
+
+		Request(queue, worldspace, { 1.0f, 2.0f });
+		queue.Process(1000000);
+		queue.NotifyCellEntered(Key(0, 0));
+		queue.NotifyCellEntered(Key(5, 5));
+		auto stats = queue.GetStats();
+		Check(stats.cellsEntered == 2 && stats.prefetchHits == 1, "prefetched: an entered prefetched cell is a hit");
+
+		// the game purged the cells, e.g. after a teleport: without the reset, cell (1, 0) would neither be queued again
+		// nor miss the hit count
+		loader->loaded.clear();
+		Request(queue, worldspace, { 1.0f, 2.0f });
+		Check(queue.GetSize() == 1, "prefetched: prefetched cells aren't queued again");
+		queue.Reset();
+		Check(queue.GetSize() == 0, "reset: the queue is empty");
+		queue.NotifyCellEntered(Key(1, 0));
+		stats = queue.GetStats();
+		Check(stats.prefetchHits == 1, "reset: the prefetched cells are forgotten");
+		Request(queue, worldspace, { 1.0f, 2.0f });
+		Check(queue.GetSize() == 2, "reset: the cells are queued again");
+
+		// a new loader resets the queue as well
+		queue.SetLoader(std::make_shared<FakeLoader>());
+		Check(queue.GetSize() == 0, "set loader: the queue is empty");
+	}
+
+	void TestAlreadyLoaded()
+	{
+		Worldspace worldspace{ 0x3C };
+		auto loader = std::make_shared<FakeLoader>();
+		loader->loaded.insert({ 1, 0 });
+		Queue queue(loader);
+
+		Request(queue, worldspace, { 1.0f, 2.0f, 3.0f });
+		Check(queue.GetSize() == 2, "loaded cells aren't queued");
+	}
+}
+
+int main() {
+	TestPriorityOrder();
+	TestDuplicatesAndTrim();
+	TestBudget();
+	TestBudgetWithFailedLoads();
+	TestPrefetchedAndReset();
+	TestAlreadyLoaded();
+
+	if (failures == 0) {
+		std::printf("CellLoadQueueTest passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
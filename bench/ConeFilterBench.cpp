@@ -0,0 +1,101 @@
+// Benchmark of the cone test kernel behind ConeFilter() on synthetic actor clouds.
+// Compares the vectorized path (AVX2 or SSE) with the scalar one and the acos-based test it replaces,
+// and checks that all three agree.
+
+#include "BenchUtil.h"
+#include "ConeFilterKernel.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace _ts_SKSEFunctions;
+
+namespace {
+	// the per-actor test used before the kernel, see GetAngleBetweenVectors()
+	void ConeFilterAcos(const std::vector<float>& a_x, const std::vector<float>& a_y, const std::vector<float>& a_z,
+						const float a_axis[3], float a_angleTolerance, std::vector<std::uint64_t>& a_outMask) {
+		std::fill(a_outMask.begin(), a_outMask.end(), 0);
+		const float axisLength = std::sqrt(a_axis[0] * a_axis[0] + a_axis[1] * a_axis[1] + a_axis[2] * a_axis[2]);
+		for (std::size_t i = 0; i < a_x.size(); ++i) {
+			const float length = std::sqrt(a_x[i] * a_x[i] + a_y[i] * a_y[i] + a_z[i] * a_z[i]);
+			if (length == 0.0f) {
+				a_outMask[i / 64] |= std::uint64_t(1) << (i % 64);
+				continue;
+			}
+			const float dot = a_x[i] * a_axis[0] + a_y[i] * a_axis[1] + a_z[i] * a_axis[2];
+			const float angle = 180.0f * std::acos(std::clamp(dot / (length * axisLength), -1.0f, 1.0f)) / 3.14159265f;
+			if (angle <= a_angleTolerance) {
+				a_outMask[i / 64] |= std::uint64_t(1) << (i % 64);
+			}
+		}
+	}
+
+	std::size_t CountMismatches(const std::vector<std::uint64_t>& a_lhs, const std::vector<std::uint64_t>& a_rhs) {
+		std::size_t mismatches = 0;
+		for (std::size_t i = 0; i < a_lhs.size(); ++i) {
+			mismatches += static_cast<std::size_t>(std::popcount(a_lhs[i] ^ a_rhs[i]));
+		}
+		return mismatches;
+	}
+}
+
+int main() {
+	std::mt19937 random(12345);
+	// actors within the loaded area around the camera at the origin
+	std::uniform_real_distribution<float> horizontal(-20000.0f, 20000.0f);
+	std::uniform_real_distribution<float> vertical(-2000.0f, 2000.0f);
+
+	const float axis[3] = { 0.3f, 0.9f, -0.1f };
+	const float angleTolerance = 30.0f;
+	ConeParams params;
+	bool allInside = false;
+	if (!GetConeParams(0.0f, 0.0f, 0.0f, axis[0], axis[1], axis[2], angleTolerance, params, allInside)) {
+		std::printf("unexpected trivial cone\n");
+		return 1;
+	}
+
+	std::printf("AVX2 %s\n", HasAVX2Support() ? "available" : "not available, SSE path");
+	std::printf("%8s %14s %14s %14s %10s\n", "actors", "acos ns/pt", "scalar ns/pt", "simd ns/pt", "mismatch");
+
+	int result = 0;
+	for (const std::size_t count : { 100, 1000, 10000 }) {
+		std::vector<float> x(count), y(count), z(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			x[i] = horizontal(random);
+			y[i] = horizontal(random);
+			z[i] = vertical(random);
+		}
+
+		const std::size_t words = (count + 63) / 64;
+		std::vector<std::uint64_t> acosMask(words), scalarMask(words), simdMask(words);
+		const std::size_t iterations = std::max<std::size_t>(1, 2000000 / count);
+
+		const double acosTime = Bench::MeasureNanoseconds([&] {
+			ConeFilterAcos(x, y, z, axis, angleTolerance, acosMask);
+			Bench::DoNotOptimize(acosMask[0]);
+		}, iterations);
+		const double scalarTime = Bench::MeasureNanoseconds([&] {
+			ConeFilterPoints(x.data(), y.data(), z.data(), count, params, scalarMask.data(), false);
+			Bench::DoNotOptimize(scalarMask[0]);
+		}, iterations);
+		const double simdTime = Bench::MeasureNanoseconds([&] {
+			ConeFilterPoints(x.data(), y.data(), z.data(), count, params, simdMask.data());
+			Bench::DoNotOptimize(simdMask[0]);
+		}, iterations);
+
+		// the acos test can differ by rounding for points right on the cone's surface, the kernels must agree exactly
+		const std::size_t mismatches = CountMismatches(scalarMask, simdMask);
+		const std::size_t acosMismatches = CountMismatches(acosMask, simdMask);
+		std::printf("%8zu %14.2f %14.2f %14.2f %6zu/%zu\n", count, acosTime / count, scalarTime / count, simdTime / count,
+			mismatches, acosMismatches);
+		if (mismatches != 0) {
+			result = 1;
+		}
+	}
+	return result;
+}
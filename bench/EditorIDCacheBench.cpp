@@ -0,0 +1,132 @@
+// Benchmark of the lookup throughput of EditorIDCache against the uncached path.
+// TESForm::LookupByEditorID() can't run off-game, so the uncached path is modelled on what it does: intern the
+// string in a case-insensitive, lock-protected string pool (BSFixedString), then look it up in the read-locked
+// editor ID map.
+
+#include "BenchUtil.h"
+#include "EditorIDCache.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace _ts_SKSEFunctions;
+
+namespace {
+	struct Form
+	{
+		std::uint32_t formID;
+	};
+
+	std::string ToLower(std::string_view a_string)
+	{
+		std::string lower(a_string);
+		for (auto& c : lower) {
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+		return lower;
+	}
+
+	class UncachedLookup
+	{
+	public:
+		void Add(std::string_view a_editorID, Form* a_form) { _forms.emplace(Intern(a_editorID), a_form); }
+
+		Form* Lookup(std::string_view a_editorID)
+		{
+			const std::string* interned = Intern(a_editorID);
+			std::shared_lock lock(_formsLock);
+			const auto it = _forms.find(interned);
+			return it != _forms.end() ? it->second : nullptr;
+		}
+
+	private:
+		const std::string* Intern(std::string_view a_string)
+		{
+			std::string lower = ToLower(a_string);
+			std::lock_guard lock(_poolLock);
+			return &*_pool.insert(std::move(lower)).first;
+		}
+
+		std::mutex _poolLock;
+		std::unordered_set<std::string> _pool;
+		std::shared_mutex _formsLock;
+		std::unordered_map<const std::string*, Form*> _forms;
+	};
+}
+
+int main() {
+	std::mt19937 random(12345);
+
+	std::printf("%8s %16s %16s %16s\n", "ids", "uncached ns/op", "cached ns/op", "warm ns/query");
+
+	int result = 0;
+	for (const std::size_t count : { 100, 1000, 10000 }) {
+		std::vector<std::string> editorIDs;
+		std::vector<Form> forms(count);
+		UncachedLookup uncached;
+		for (std::size_t i = 0; i < count; ++i) {
+			editorIDs.push_back("BenchmarkEditorID" + std::to_string(i) + "Form");
+			forms[i].formID = static_cast<std::uint32_t>(i);
+			uncached.Add(editorIDs.back(), &forms[i]);
+		}
+		// a quarter of the queries are unknown editor IDs, which are cached as well, and a quarter use another case
+		std::vector<std::string> queryStorage;
+		std::uniform_int_distribution<std::size_t> pick(0, count - 1);
+		for (std::size_t i = 0; i < 4096; ++i) {
+			if (i % 4 == 0) {
+				queryStorage.push_back("UnknownEditorID" + std::to_string(pick(random)));
+			} else if (i % 4 == 1) {
+				queryStorage.push_back(ToLower(editorIDs[pick(random)]));
+			} else {
+				queryStorage.push_back(editorIDs[pick(random)]);
+			}
+		}
+		std::unordered_set<std::string> distinctQueries;
+		for (const auto& query : queryStorage) {
+			distinctQueries.insert(ToLower(query));
+		}
+		const std::vector<std::string_view> queries(queryStorage.begin(), queryStorage.end());
+
+		auto resolve = [&](std::string_view a_editorID) { return uncached.Lookup(a_editorID); };
+		EditorIDCache<Form*> cache;
+
+		const double uncachedTime = Bench::MeasureNanoseconds([&] {
+			for (const auto editorID : queries) {
+				Bench::DoNotOptimize(uncached.Lookup(editorID));
+			}
+		}, 50);
+		const double warmTime = Bench::MeasureNanoseconds([&] {
+			cache.Clear();
+			Bench::DoNotOptimize(cache.Warm(queries, resolve));
+		}, 10);
+		const double cachedTime = Bench::MeasureNanoseconds([&] {
+			for (const auto editorID : queries) {
+				Bench::DoNotOptimize(cache.Lookup(editorID, resolve));
+			}
+		}, 50);
+
+		for (const auto editorID : queries) {
+			if (cache.Lookup(editorID, resolve) != uncached.Lookup(editorID)) {
+				result = 1;
+			}
+		}
+		// editor IDs differing only in case share an entry
+		if (cache.size() != distinctQueries.size()) {
+			std::printf("%zu entries cached for %zu distinct editor IDs\n", cache.size(), distinctQueries.size());
+			result = 1;
+		}
+
+		std::printf("%8zu %16.1f %16.1f %16.1f\n", count, uncachedTime / queries.size(), cachedTime / queries.size(),
+			warmTime / queries.size());
+	}
+	return result;
+}
@@ -0,0 +1,89 @@
+// Microbenchmark of the batched body part rotation behind GetRotationsFromFrames(): the vectorized atan2 path
+// against the precise scalar path, on random orthonormal frames plus the vertical edge cases.
+// Also reports the largest angle difference between the two paths.
+
+#include "BenchUtil.h"
+#include "RotationKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace _ts_SKSEFunctions;
+
+namespace {
+	// difference of two angles, wrapped into [0, pi]
+	float AngleDifference(float a_lhs, float a_rhs) {
+		return std::fabs(std::remainder(a_lhs - a_rhs, 2.0f * 3.1415926535f));
+	}
+
+	// appends a random orthonormal frame (forward and up, 3 floats each)
+	void AddRandomFrame(std::mt19937& a_random, std::vector<float>& a_forward, std::vector<float>& a_up) {
+		std::normal_distribution<float> normal;
+		float f[3] = { normal(a_random), normal(a_random), normal(a_random) };
+		float r[3] = { normal(a_random), normal(a_random), normal(a_random) };
+		const float fLength = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+		for (auto& value : f) {
+			value /= fLength;
+		}
+		// up = normalize(r - (r.f) f)
+		const float dot = r[0] * f[0] + r[1] * f[1] + r[2] * f[2];
+		float u[3] = { r[0] - dot * f[0], r[1] - dot * f[1], r[2] - dot * f[2] };
+		const float uLength = std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+		for (auto& value : u) {
+			value /= uLength;
+		}
+		a_forward.insert(a_forward.end(), f, f + 3);
+		a_up.insert(a_up.end(), u, u + 3);
+	}
+}
+
+int main() {
+	std::mt19937 random(12345);
+
+	std::printf("%8s %16s %16s %14s\n", "frames", "precise ns/frm", "simd ns/frm", "max error rad");
+
+	// documented bound of the vectorized path, see RotationsFromFrames()
+	constexpr float kMaxError = 5e-6f;
+	int result = 0;
+	for (const std::size_t count : { 16, 256, 10000 }) {
+		std::vector<float> forward, up;
+		forward.reserve(3 * count);
+		up.reserve(3 * count);
+		// looking straight up and down, where yaw comes from atan2(0, 0)
+		const float edgeForward[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f };
+		const float edgeUp[] = { 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+		forward.insert(forward.end(), edgeForward, edgeForward + 6);
+		up.insert(up.end(), edgeUp, edgeUp + 6);
+		while (forward.size() < 3 * count) {
+			AddRandomFrame(random, forward, up);
+		}
+
+		std::vector<float> precisePitch(count), preciseRoll(count), preciseYaw(count);
+		std::vector<float> pitch(count), roll(count), yaw(count);
+		const std::size_t iterations = std::max<std::size_t>(1, 1000000 / count);
+
+		const double preciseTime = Bench::MeasureNanoseconds([&] {
+			RotationsFromFrames(forward.data(), up.data(), count, precisePitch.data(), preciseRoll.data(), preciseYaw.data(), true);
+			Bench::DoNotOptimize(preciseYaw[0]);
+		}, iterations);
+		const double simdTime = Bench::MeasureNanoseconds([&] {
+			RotationsFromFrames(forward.data(), up.data(), count, pitch.data(), roll.data(), yaw.data(), false);
+			Bench::DoNotOptimize(yaw[0]);
+		}, iterations);
+
+		float maxError = 0.0f;
+		for (std::size_t i = 0; i < count; ++i) {
+			maxError = std::max({ maxError, AngleDifference(pitch[i], precisePitch[i]), AngleDifference(roll[i], preciseRoll[i]),
+				AngleDifference(yaw[i], preciseYaw[i]) });
+		}
+
+		std::printf("%8zu %16.2f %16.2f %14.2e\n", count, preciseTime / count, simdTime / count, maxError);
+		if (maxError > kMaxError) {
+			result = 1;
+		}
+	}
+	return result;
+}
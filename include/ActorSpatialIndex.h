@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace _ts_SKSEFunctions {
+	// Uniform grid over the XY plane holding point indices, keyed on the exterior cell size used by GetCell().
+	// Radius queries only visit the buckets overlapping the query circle and return candidate indices,
+	// the exact distance test is left to the caller. Takes plain x/y coordinates and has no CommonLibSSE dependency,
+	// so it can be used and benchmarked off-game as well (see bench/).
+	class ActorSpatialIndex
+	{
+	public:
+		static constexpr float kCellSize = 4096.0f;
+
+		explicit ActorSpatialIndex(float a_cellSize = kCellSize) : _cellSize(a_cellSize) {}
+
+		// removes all points, but keeps the buckets' memory for the next rebuild
+		void Clear();
+
+		// rebuilds the index from contiguous coordinate arrays; point i gets index i
+		// buckets that stayed empty after the rebuild are released
+		void Build(std::span<const float> a_x, std::span<const float> a_y);
+
+		void Insert(std::uint32_t a_index, float a_x, float a_y);
+
+		void Remove(std::uint32_t a_index, float a_x, float a_y);
+
+		// moves a point from its old to its new position, only touching the buckets if it changed cells
+		void Update(std::uint32_t a_index, float a_oldX, float a_oldY, float a_newX, float a_newY);
+
+		// calls a_func(index) for all points in buckets overlapping the circle around (a_centerX, a_centerY)
+		template <class Func>
+		void ForEachInRadius(float a_centerX, float a_centerY, float a_radius, Func&& a_func) const
+		{
+			const std::int32_t minX = GetCellCoord(a_centerX - a_radius);
+			const std::int32_t maxX = GetCellCoord(a_centerX + a_radius);
+			const std::int32_t minY = GetCellCoord(a_centerY - a_radius);
+			const std::int32_t maxY = GetCellCoord(a_centerY + a_radius);
+
+			const auto cellCount = static_cast<std::uint64_t>(maxX - minX + 1) * static_cast<std::uint64_t>(maxY - minY + 1);
+			if (cellCount > _buckets.size()) {
+				// the range covers more cells than there are buckets, so walk the buckets instead
+				for (const auto& [key, indices] : _buckets) {
+					const auto [cellX, cellY] = GetCellCoords(key);
+					if (cellX >= minX && cellX <= maxX && cellY >= minY && cellY <= maxY) {
+						for (auto index : indices) {
+							a_func(index);
+						}
+					}
+				}
+				return;
+			}
+
+			for (std::int32_t cellX = minX; cellX <= maxX; ++cellX) {
+				for (std::int32_t cellY = minY; cellY <= maxY; ++cellY) {
+					const auto it = _buckets.find(GetKey(cellX, cellY));
+					if (it != _buckets.end()) {
+						for (auto index : it->second) {
+							a_func(index);
+						}
+					}
+				}
+			}
+		}
+
+		// appends the candidate indices within a_radius of (a_centerX, a_centerY) to a_out
+		void QueryRadius(float a_centerX, float a_centerY, float a_radius, std::vector<std::uint32_t>& a_out) const;
+
+		[[nodiscard]] std::size_t GetBucketCount() const { return _buckets.size(); }
+		[[nodiscard]] float GetCellSize() const { return _cellSize; }
+
+	private:
+		[[nodiscard]] std::int32_t GetCellCoord(float a_value) const
+		{
+			const float cell = std::floor(a_value / _cellSize);
+			// clamp, so that unbounded radii don't overflow the cell coordinates
+			return static_cast<std::int32_t>(std::clamp(cell, -1048576.0f, 1048576.0f));
+		}
+
+		[[nodiscard]] static std::uint64_t GetKey(std::int32_t a_cellX, std::int32_t a_cellY)
+		{
+			return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a_cellX)) << 32) | static_cast<std::uint32_t>(a_cellY);
+		}
+
+		[[nodiscard]] static std::pair<std::int32_t, std::int32_t> GetCellCoords(std::uint64_t a_key)
+		{
+			return { static_cast<std::int32_t>(a_key >> 32), static_cast<std::int32_t>(a_key & 0xFFFFFFFF) };
+		}
+
+		std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> _buckets;
+		float _cellSize;
+	};
+}
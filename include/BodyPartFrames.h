@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Body part axis mappings and their INI parser behind BodyPartFrameTable, written against plain floats without
+// CommonLibSSE, so they can be built and tested off-game (see bench/).
+namespace _ts_SKSEFunctions {
+	// Signed permutation of a body part node's rotation axes, telling which of them are forward, right and up.
+	// axis selects the rotation matrix column (0 = X, 1 = Y, 2 = Z) and sign its direction, in the order forward, right, up.
+	struct BodyPartAxisMapping
+	{
+		std::array<std::uint8_t, 3> axis{ 1, 0, 2 };  // default: forward = +Y, right = +X, up = +Z (standard humanoid)
+		std::array<std::int8_t, 3> sign{ 1, 1, 1 };
+
+		// parses "<forward> <right> <up>", eg "+Y +X +Z" or "+X -Z -Y"; the three axes must be distinct
+		static std::optional<BodyPartAxisMapping> Parse(std::string_view a_text);
+
+		[[nodiscard]] std::string ToString() const;
+
+		// a_rotation is a row-major 3x3 matrix laid out like RE::NiMatrix3, whose columns are the node's axes.
+		// Writes 3 floats to each of a_forward, a_right and a_up
+		void Apply(const float* a_rotation, float* a_forward, float* a_right, float* a_up) const;
+
+		bool operator==(const BodyPartAxisMapping&) const = default;
+	};
+
+	// the INI sections, in the order of RE::BGSBodyPartDefs::LIMB_ENUM
+	inline constexpr std::array<std::string_view, 6> kBodyPartLimbNames{ "Torso", "Head", "Eye", "LookAt", "FlyGrab", "Saddle" };
+
+	using BodyPartLimbMappings = std::array<std::optional<BodyPartAxisMapping>, kBodyPartLimbNames.size()>;
+
+	// built-in mappings of the vanilla and DLC body part data, in the format of BodyPartFrameMappings::Parse()
+	extern const std::string_view kDefaultBodyPartFrames;
+
+	// Axis mappings per body part data editor ID (case-insensitive) and limb, read from INI data:
+	//     [Head]                                ; section = limb name, see kBodyPartLimbNames
+	//     MyCreatureBodyPartData = +X -Z -Y     ; BGSBodyPartData editor ID = <forward> <right> <up>
+	class BodyPartFrameMappings
+	{
+	public:
+		// Adds the mappings of a_data, overriding existing ones for the same editor ID and limb, returns their number.
+		// Malformed lines, unknown sections and invalid mappings are skipped and described in a_warnings (if given).
+		std::size_t Parse(std::string_view a_data, std::vector<std::string>* a_warnings = nullptr);
+
+		void Set(std::size_t a_limb, std::string_view a_editorID, const BodyPartAxisMapping& a_mapping);
+
+		// returns nullptr if a_editorID has no mappings
+		[[nodiscard]] const BodyPartLimbMappings* Find(std::string_view a_editorID) const;
+
+		void Clear() { _byEditorID.clear(); }
+		[[nodiscard]] std::size_t size() const { return _byEditorID.size(); }
+
+		static std::string NormalizeEditorID(std::string_view a_editorID);
+
+	private:
+		std::unordered_map<std::string, BodyPartLimbMappings> _byEditorID;  // lower case editor ID
+	};
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace _ts_SKSEFunctions {
+	// Queue of cell loads behind CellPrefetcher: keeps the most urgent requests and loads them within a per-frame
+	// time budget. Templated on the worldspace type and free of CommonLibSSE, so the scheduling can be tested off-game
+	// with a fake loader (see bench/).
+	template <class Worldspace>
+	class CellLoadQueue
+	{
+	public:
+		// performs the cell loads, replaceable to test the prediction and scheduling without the game
+		class ICellLoader
+		{
+		public:
+			virtual ~ICellLoader() = default;
+
+			virtual bool IsLoaded(Worldspace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) = 0;
+			virtual bool Load(Worldspace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) = 0;
+
+			// called around the loads of a frame
+			virtual void BeginLoads() {}
+			virtual void EndLoads() {}
+
+			// clock of the frame budget in microseconds, a test loader can simulate load times with it
+			virtual std::uint64_t GetTime_us()
+			{
+				return static_cast<std::uint64_t>(
+					std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+			}
+		};
+
+		struct Stats
+		{
+			std::uint64_t predictions = 0;      // cells queued
+			std::uint64_t loads = 0;            // load attempts, including the failed ones
+			std::uint64_t failedLoads = 0;
+			std::uint64_t budgetExhausted = 0;  // frames that left requests in the queue because of the budget
+			std::uint64_t loadTime = 0;         // microseconds, total of all loads
+			std::uint64_t maxLoadTime = 0;      // microseconds
+			std::uint64_t cellsEntered = 0;
+			std::uint64_t prefetchHits = 0;     // entered cells that were prefetched
+
+			[[nodiscard]] float GetHitRate() const { return cellsEntered ? static_cast<float>(prefetchHits) / cellsEntered : 0.0f; }
+			[[nodiscard]] float GetAverageLoadTime() const { return loads ? static_cast<float>(loadTime) / loads : 0.0f; }
+		};
+
+		// receives the requests of SetRequests(), must be called with the queue's lock held (which SetRequests() does)
+		class Builder
+		{
+		public:
+			void Add(Worldspace* a_worldspace, std::uint64_t a_key, std::int16_t a_cellX, std::int16_t a_cellY, float a_priority)
+			{
+				_queue.Add(a_worldspace, a_key, a_cellX, a_cellY, a_priority);
+			}
+
+		private:
+			friend class CellLoadQueue;
+			explicit Builder(CellLoadQueue& a_queue) : _queue(a_queue) {}
+
+			CellLoadQueue& _queue;
+		};
+
+		explicit CellLoadQueue(std::shared_ptr<ICellLoader> a_loader) : _loader(std::move(a_loader)) {}
+
+		void SetLoader(std::shared_ptr<ICellLoader> a_loader)
+		{
+			std::lock_guard lock(_lock);
+			_loader = std::move(a_loader);
+			ResetLocked();
+		}
+
+		// drops the queued requests and forgets which cells were prefetched, as the game may have purged them since
+		// (teleports, worldspace changes, game loads)
+		void Reset()
+		{
+			std::lock_guard lock(_lock);
+			ResetLocked();
+		}
+
+		// Replaces the queued requests by the ones a_build(Builder&) adds, keeping the a_maxSize most urgent ones.
+		// Cells that are already loaded or were prefetched are skipped, a cell added twice keeps its lowest priority.
+		template <class Func>
+		void SetRequests(Func&& a_build, std::size_t a_maxSize)
+		{
+			std::lock_guard lock(_lock);
+			_queue.clear();
+			_queueIndex.clear();
+
+			Builder builder(*this);
+			a_build(builder);
+
+			// keep the most urgent requests, lowest priority value (earliest needed) on top of the heap
+			if (_queue.size() > a_maxSize) {
+				std::nth_element(_queue.begin(), _queue.begin() + static_cast<std::ptrdiff_t>(a_maxSize), _queue.end(),
+					[](const Request& a_lhs, const Request& a_rhs) { return a_lhs.priority < a_rhs.priority; });
+				_queue.resize(a_maxSize);
+			}
+			_queueIndex.clear();
+			std::make_heap(_queue.begin(), _queue.end(), CompareRequests);
+		}
+
+		// Loads the most urgent requests until a_frameBudget_us is used up, returns the number of cells loaded.
+		// At least one load is attempted per call, so a budget smaller than a single load still makes progress.
+		// The loads run without the lock held, concurrent calls return 0 while another one is loading.
+		std::size_t Process(std::uint64_t a_frameBudget_us)
+		{
+			std::shared_ptr<ICellLoader> loader;
+			{
+				std::lock_guard lock(_lock);
+				if (_processing || _queue.empty() || !_loader) {
+					return 0;
+				}
+				_processing = true;
+				loader = _loader;
+			}
+
+			const std::uint64_t start = loader->GetTime_us();
+			std::size_t attempts = 0;
+			std::size_t loaded = 0;
+
+			loader->BeginLoads();
+			while (true) {
+				Request request;
+				{
+					std::lock_guard lock(_lock);
+					if (_queue.empty()) {
+						break;
+					}
+					if (attempts > 0 && loader->GetTime_us() - start >= a_frameBudget_us) {
+						++_stats.budgetExhausted;
+						break;
+					}
+
+					std::pop_heap(_queue.begin(), _queue.end(), CompareRequests);
+					request = _queue.back();
+					_queue.pop_back();
+				}
+
+				const std::uint64_t loadStart = loader->GetTime_us();
+				const bool success = loader->Load(request.worldspace, request.cellX, request.cellY);
+				const std::uint64_t latency = loader->GetTime_us() - loadStart;
+				++attempts;
+
+				std::lock_guard lock(_lock);
+				++_stats.loads;
+				_stats.loadTime += latency;
+				_stats.maxLoadTime = std::max(_stats.maxLoadTime, latency);
+				if (success) {
+					if (_prefetched.size() >= kMaxPrefetchedCells) {
+						_prefetched.clear();
+					}
+					_prefetched.insert(request.key);
+					++loaded;
+				} else {
+					++_stats.failedLoads;
+				}
+			}
+			loader->EndLoads();
+
+			std::lock_guard lock(_lock);
+			_processing = false;
+			return loaded;
+		}
+
+		// counts the entered cell as a prefetch hit if the queue loaded it
+		void NotifyCellEntered(std::uint64_t a_key)
+		{
+			std::lock_guard lock(_lock);
+			++_stats.cellsEntered;
+			if (_prefetched.erase(a_key) > 0) {
+				++_stats.prefetchHits;
+			}
+		}
+
+		[[nodiscard]] std::size_t GetSize() const
+		{
+			std::lock_guard lock(_lock);
+			return _queue.size();
+		}
+
+		[[nodiscard]] Stats GetStats() const
+		{
+			std::lock_guard lock(_lock);
+			return _stats;
+		}
+
+		void ResetStats()
+		{
+			std::lock_guard lock(_lock);
+			_stats = Stats();
+		}
+
+	private:
+		static constexpr std::size_t kMaxPrefetchedCells = 1024;
+
+		struct Request
+		{
+			float        priority = 0.0f;  // seconds until the cell is needed
+			std::uint64_t key = 0;
+			Worldspace*  worldspace = nullptr;
+			std::int16_t cellX = 0;
+			std::int16_t cellY = 0;
+		};
+
+		static bool CompareRequests(const Request& a_lhs, const Request& a_rhs) { return a_lhs.priority > a_rhs.priority; }
+
+		// must be called with _lock held
+		void ResetLocked()
+		{
+			_queue.clear();
+			_queueIndex.clear();
+			_prefetched.clear();
+		}
+
+		// must be called with _lock held, from SetRequests()
+		void Add(Worldspace* a_worldspace, std::uint64_t a_key, std::int16_t a_cellX, std::int16_t a_cellY, float a_priority)
+		{
+			if (const auto it = _queueIndex.find(a_key); it != _queueIndex.end()) {
+				auto& request = _queue[it->second];
+				request.priority = std::min(request.priority, a_priority);
+				return;
+			}
+			if (_prefetched.contains(a_key) || !_loader || _loader->IsLoaded(a_worldspace, a_cellX, a_cellY)) {
+				return;
+			}
+
+			++_stats.predictions;
+			_queueIndex.emplace(a_key, _queue.size());
+			_queue.push_back({ a_priority, a_key, a_worldspace, a_cellX, a_cellY });
+		}
+
+		mutable std::mutex _lock;
+		std::shared_ptr<ICellLoader> _loader;
+		Stats _stats;
+		std::vector<Request> _queue;  // heap, most urgent request on top
+		std::unordered_map<std::uint64_t, std::size_t> _queueIndex;  // key -> index in _queue, only valid in SetRequests()
+		std::unordered_set<std::uint64_t> _prefetched;  // cells loaded by the queue and not entered yet
+		bool _processing = false;
+	};
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Cone test kernel behind ConeFilter(), written against plain floats without CommonLibSSE,
+// so it can be built and benchmarked off-game (see bench/).
+namespace _ts_SKSEFunctions {
+	struct ConeParams
+	{
+		float apexX, apexY, apexZ;
+		float axisX, axisY, axisZ;  // normalized
+		float cosThreshold;
+	};
+
+	// Computes the parameters of the cone with the given apex, axis and half-angle (in degrees).
+	// returns false if the result doesn't depend on the point positions, in which case a_allInside tells the result
+	bool GetConeParams(float a_apexX, float a_apexY, float a_apexZ, float a_axisX, float a_axisY, float a_axisZ,
+					   float a_angleTolerance, ConeParams& a_params, bool& a_allInside);
+
+	// Sets bit i of a_outMask if point i is inside the cone: dot(p - apex, axis) >= cos(tolerance) * |p - apex|.
+	// a_outMask must hold (a_count + 63) / 64 words, which are overwritten.
+	// With a_vectorized, 8 points are tested at a time (AVX2 if the CPU supports it, SSE otherwise).
+	void ConeFilterPoints(const float* a_x, const float* a_y, const float* a_z, std::size_t a_count,
+						  const ConeParams& a_params, std::uint64_t* a_outMask, bool a_vectorized = true);
+
+	// sets the first a_count bits of a_outMask if a_allInside, clears them otherwise
+	void FillConeMask(std::size_t a_count, bool a_allInside, std::uint64_t* a_outMask);
+
+	bool HasAVX2Support();
+}
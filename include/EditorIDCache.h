@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace _ts_SKSEFunctions {
+	// Thread-safe cache from editor ID to a resolved value, behind LookupFormByEditorID().
+	// Editor IDs are case-insensitive like TESForm::LookupByEditorID(), "IronSword" and "ironsword" share an entry.
+	// Lookups take a std::string_view and need no temporary std::string. The resolver is passed per call,
+	// so the cache has no CommonLibSSE dependency and can be benchmarked off-game (see bench/).
+	template <class T>
+	class EditorIDCache
+	{
+	public:
+		// returns the cached value of a_editorID, or resolves and caches it with a_resolve(a_editorID).
+		// Values that resolve to "not found" are cached as well, they are as expensive to look up as the others
+		template <class Resolve>
+		T Lookup(std::string_view a_editorID, Resolve&& a_resolve)
+		{
+			{
+				std::shared_lock lock(_lock);
+				if (const auto it = _entries.find(a_editorID); it != _entries.end()) {
+					return it->second;
+				}
+			}
+
+			T value = a_resolve(a_editorID);
+			std::unique_lock lock(_lock);
+			return _entries.try_emplace(std::string(a_editorID), value).first->second;
+		}
+
+		// resolves all editor IDs that aren't cached yet, returns the number of them that resolved to a non-null value.
+		// The resolves run without the lock held, so lookups of other threads aren't blocked by a large batch
+		template <class Resolve>
+		std::size_t Warm(std::span<const std::string_view> a_editorIDs, Resolve&& a_resolve)
+		{
+			std::vector<std::pair<std::string_view, T>> missing;
+			std::size_t resolved = 0;
+			{
+				std::shared_lock lock(_lock);
+				for (const auto editorID : a_editorIDs) {
+					if (const auto it = _entries.find(editorID); it == _entries.end()) {
+						missing.emplace_back(editorID, T{});
+					} else if (it->second) {
+						++resolved;
+					}
+				}
+			}
+			if (missing.empty()) {
+				return resolved;
+			}
+
+			for (auto& [editorID, value] : missing) {
+				value = a_resolve(editorID);
+			}
+
+			std::unique_lock lock(_lock);
+			_entries.reserve(_entries.size() + missing.size());
+			for (const auto& [editorID, value] : missing) {
+				// another thread (or a duplicate in a_editorIDs) may have added it meanwhile, the first value is kept
+				if (_entries.try_emplace(std::string(editorID), value).first->second) {
+					++resolved;
+				}
+			}
+			return resolved;
+		}
+
+		void Clear()
+		{
+			std::unique_lock lock(_lock);
+			_entries.clear();
+		}
+
+		[[nodiscard]] std::size_t size() const
+		{
+			std::shared_lock lock(_lock);
+			return _entries.size();
+		}
+
+	private:
+		static constexpr char ToLower(char a_c) { return a_c >= 'A' && a_c <= 'Z' ? static_cast<char>(a_c - 'A' + 'a') : a_c; }
+
+		// case-insensitive FNV-1a, accepting std::string_view so lookups don't need a temporary (lower case) std::string
+		struct Hash
+		{
+			using is_transparent = void;
+
+			std::size_t operator()(std::string_view a_editorID) const noexcept
+			{
+				std::uint64_t hash = 14695981039346656037ull;
+				for (const char c : a_editorID) {
+					hash = (hash ^ static_cast<unsigned char>(ToLower(c))) * 1099511628211ull;
+				}
+				return static_cast<std::size_t>(hash);
+			}
+		};
+
+		struct Equal
+		{
+			using is_transparent = void;
+
+			bool operator()(std::string_view a_lhs, std::string_view a_rhs) const noexcept
+			{
+				return a_lhs.size() == a_rhs.size() &&
+				       std::equal(a_lhs.begin(), a_lhs.end(), a_rhs.begin(), [](char a_l, char a_r) { return ToLower(a_l) == ToLower(a_r); });
+			}
+		};
+
+		mutable std::shared_mutex _lock;
+		std::unordered_map<std::string, T, Hash, Equal> _entries;  // keyed by the first spelling looked up
+	};
+}
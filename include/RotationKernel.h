@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// Pitch/roll/yaw kernel behind GetRotationsFromFrames(), written against plain floats without CommonLibSSE,
+// so it can be built and benchmarked off-game (see bench/).
+namespace _ts_SKSEFunctions {
+	// computes pitch/roll/yaw like GetBodyPartRotation() from a body part's forward and up vectors (3 floats each)
+	void RotationFromFrame(const float* a_forward, const float* a_up, float& a_pitch, float& a_roll, float& a_yaw);
+
+	// Batch version of RotationFromFrame(): a_forward and a_up hold a_count vectors of 3 floats (x, y, z) each,
+	// laid out like an array of RE::NiPoint3.
+	// Unless a_precise is set, the angles are computed 4 at a time with a polynomial atan2 approximation
+	// (max error of the approximation < 1e-6 rad, resulting angles within 5e-6 rad of the precise path).
+	void RotationsFromFrames(const float* a_forward, const float* a_up, std::size_t a_count,
+							 float* a_pitch, float* a_roll, float* a_yaw, bool a_precise = false);
+}
@@ -5,6 +5,20 @@
 #include <SimpleIni.h>
 #include <thread>
 #include <future>
+#include <array>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ActorSpatialIndex.h"
+#include "BodyPartFrames.h"
+#include "CellLoadQueue.h"
 
 #define PI 3.1415926535f
 
@@ -12,6 +26,10 @@ namespace _ts_SKSEFunctions {
 
     void InitializeLogging(spdlog::level::level_enum a_loglevel = spdlog::level::level_enum::info);
 
+	// Calls a_callback on the main thread after a game was loaded (TESLoadGameEvent), used by the caches below that
+	// must not survive a load. Adding the same callback again has no effect.
+	void AddLoadGameCallback(void (*a_callback)());
+
 	void WaitWhileGameIsPaused(int a_checkInterval_ms = 100);
 
 	RE::VMHandle GetHandle(const RE::TESForm* a_akForm);
@@ -39,16 +57,217 @@ namespace _ts_SKSEFunctions {
 
 	void SendCustomEvent(RE::VMHandle a_handle, std::string a_eventName, RE::BSScript::IFunctionArguments * a_args);
 
+
+	// Cached TESForm::LookupByEditorID(): each editor ID (case-insensitive) is only looked up in the game's editor ID map once.
+	// Unknown editor IDs are cached too, the cache is cleared when a game is loaded. Call ClearEditorIDCache() on new game.
+	RE::TESForm* LookupFormByEditorID(std::string_view a_editorID);
+
+	template <class T>
+	T* LookupFormByEditorID(std::string_view a_editorID)
+	{
+		auto* form = LookupFormByEditorID(a_editorID);
+		return form ? form->As<T>() : nullptr;
+	}
+
+	// resolves a batch of editor IDs (eg at startup) so later lookups are cache hits, returns the number of known ones
+	std::size_t WarmEditorIDCache(std::span<const std::string_view> a_editorIDs);
+
+	void ClearEditorIDCache();
+	// returns true if a_CheckPackage (or a_akActor's current package if None) is in a_Packagelist
+	// the packages of each list are cached as sorted FormIDs, the cache entry is rebuilt when the list's forms change
 	bool CheckForPackage(RE::Actor* a_akActor, const RE::BGSListForm* a_Packagelist, RE::TESPackage* a_CheckPackage = nullptr);
 
+	// batch version of CheckForPackage(): bit i of a_outMask is set if a_actors[i] runs a package from a_Packagelist
+	// a_outMask must hold at least (count + 63) / 64 words
+	void CheckForPackage(std::span<RE::Actor* const> a_actors, const RE::BGSListForm* a_Packagelist, std::span<std::uint64_t> a_outMask);
+
+	// drops the cached package lists, done automatically when a game is loaded
+	void ClearPackageListCache();
+
+	// A condition function test: <function> <opCode> <comparisonValue>, eg GetIsFlying == 1
+	struct ConditionDescriptor
+	{
+		RE::FUNCTION_DATA::FunctionID function;
+		float comparisonValue = 1.0f;
+		RE::CONDITION_ITEM_DATA::OpCode opCode = RE::CONDITION_ITEM_DATA::OpCode::kEqualTo;
+
+		[[nodiscard]] std::uint64_t GetKey() const;
+	};
+
+	// The condition functions used by this library. New checks only need a descriptor here and a call to EvaluateCondition().
+	namespace Conditions
+	{
+		using FunctionID = RE::FUNCTION_DATA::FunctionID;
+
+		inline constexpr ConditionDescriptor kIsPlayerInRegion{ FunctionID::kIsPlayerInRegion };                        // param 0: TESRegion
+		inline constexpr ConditionDescriptor kGetIsFlying{ FunctionID::kGetIsFlying };
+		inline constexpr ConditionDescriptor kGetLineOfSight{ FunctionID::kGetLineOfSight };                            // param 0: target reference
+		inline constexpr ConditionDescriptor kIsFlyingMountPatrolQueued{ FunctionID::kIsFlyingMountPatrolQueued };
+		inline constexpr ConditionDescriptor kIsFlyingMountFastTravelling{ FunctionID::kIsFlyingMountFastTravelling };
+
+	}
+
+	// Hands out TESCondition instances per descriptor. Each thread gets its own instances, so conditions can be evaluated
+	// concurrently from worker and Papyrus threads although their params are set in place.
+	class ConditionCache
+	{
+	public:
+		// returns the calling thread's condition for a_descriptor, created on first use
+		static RE::TESCondition* Get(const ConditionDescriptor& a_descriptor);
+	};
+
+	// evaluates a_descriptor on a_subject with the given function parameters (forms or integers, depending on the function)
+	bool EvaluateCondition(const ConditionDescriptor& a_descriptor, RE::TESObjectREFR* a_subject, void* a_param0 = nullptr, void* a_param1 = nullptr);
+
+	// calls the condition function once and returns its raw value, eg the state for GetFlyingState or GetCombatState,
+	// instead of testing it against one comparison value after the other
+	// returns std::nullopt if a_function has no condition function or it failed
+	std::optional<double> EvaluateConditionValue(RE::FUNCTION_DATA::FunctionID a_function, RE::TESObjectREFR* a_subject,
+												 void* a_param0 = nullptr, void* a_param1 = nullptr);
+
+	struct ActorSnapshot;
+
+	// Batch versions of EvaluateCondition(): bit i of a_outMask is set if the condition is true for actor i.
+	// a_outMask must hold at least (count + 63) / 64 words. Each actor is validated once, invalid actors get a cleared bit.
+	// The snapshot overloads skip the validation, its actors were resolved from their handles in the current frame.
+	void EvaluateConditions(const ConditionDescriptor& a_descriptor, std::span<RE::Actor* const> a_actors, std::span<std::uint64_t> a_outMask,
+							void* a_param0 = nullptr, void* a_param1 = nullptr);
+	void EvaluateConditions(const ConditionDescriptor& a_descriptor, const ActorSnapshot& a_snapshot, std::span<std::uint64_t> a_outMask,
+							void* a_param0 = nullptr, void* a_param1 = nullptr);
+
+	// Batch versions of EvaluateConditionValue(): a_out[i] is the value for actor i, or a_invalidValue if the actor is invalid
+	// or the evaluation failed (eg EvaluateConditionValues(FunctionID::kGetCombatState, *GetActorSnapshot(), states))
+	void EvaluateConditionValues(RE::FUNCTION_DATA::FunctionID a_function, std::span<RE::Actor* const> a_actors, std::span<int> a_out,
+								 void* a_param0 = nullptr, void* a_param1 = nullptr, int a_invalidValue = -1);
+	void EvaluateConditionValues(RE::FUNCTION_DATA::FunctionID a_function, const ActorSnapshot& a_snapshot, std::span<int> a_out,
+								 void* a_param0 = nullptr, void* a_param1 = nullptr, int a_invalidValue = -1);
+
     bool IsPlayerInRegion(const std::string& a_regionName);
 
+	// Tracks the player's membership in a set of regions.
+	// The region forms are resolved once when added, and the membership is only re-evaluated when the player's cell
+	// changes, so IsPlayerInRegion() can be polled cheaply. Call Update() regularly (eg once per frame or from a
+	// Papyrus update) to get enter/exit notifications:
+	// - C++ callbacks, called with the region, its editor ID and whether it was entered or left
+	// - Papyrus events kEnterEvent/kExitEvent(string asRegion) on the registered VM handles
+	class RegionTracker
+	{
+	public:
+		using Callback = std::function<void(RE::TESRegion* a_region, std::string_view a_editorID, bool a_entered)>;
+
+		static constexpr std::string_view kEnterEvent = "OnPlayerRegionEnter";
+		static constexpr std::string_view kExitEvent = "OnPlayerRegionExit";
+
+		static RegionTracker* GetSingleton();
+
+		// returns false if a_editorID is not a region
+		bool AddRegion(std::string_view a_editorID);
+		void RemoveRegion(std::string_view a_editorID);
+		void Clear();
+
+		// returns an ID for RemoveCallback()
+		std::size_t AddCallback(Callback a_callback);
+		void RemoveCallback(std::size_t a_callbackID);
+
+		void RegisterForEvents(RE::VMHandle a_handle);
+		void UnregisterForEvents(RE::VMHandle a_handle);
+
+		// re-evaluates the regions if the player changed cell (or a_force is set) and notifies about changes
+		void Update(bool a_force = false);
+
+		// adds the region if it isn't tracked yet and returns the cached membership
+		bool IsPlayerInRegion(std::string_view a_editorID);
+
+	private:
+		struct TrackedRegion
+		{
+			std::string    editorID;
+			RE::TESRegion* region;
+			bool           inside;
+		};
+
+		// must be called with _lock held
+		TrackedRegion* FindRegion(std::string_view a_editorID);
+
+		std::mutex _lock;
+		std::vector<TrackedRegion> _regions;
+		std::vector<std::pair<std::size_t, Callback>> _callbacks;
+		std::size_t _lastCallbackID = 0;
+		std::vector<RE::VMHandle> _eventHandles;
+		RE::TESObjectCELL* _lastCell = nullptr;
+		bool _dirty = true;
+	};
+
 	int GetFlyingState(RE::Actor* a_akActor);
 
 	bool IsFlying(RE::Actor* a_akActor);
 
 	bool HasLOS(RE::Actor* a_akActor, RE::TESObjectREFR* a_target);
 
+	// Cache of HasLOS() results per (observer, target) pair, for systems asking the same pairs within a frame.
+	// A result is reused for the TTL, in milliseconds (SetTTL()) or in frames (SetTTLFrames()). The time stamp is the
+	// application runtime, which only advances once per frame, so a TTL of 0 reuses results within the frame they were
+	// computed in; a frame TTL keeps the reuse independent of the frame rate.
+	// A result is dropped as soon as the observer or the target is in a different cell.
+	class LOSCache
+	{
+	public:
+		struct Stats
+		{
+			std::uint64_t hits = 0;
+			std::uint64_t staleHits = 0;      // results older than the TTL, returned because the caller allowed it
+			std::uint64_t misses = 0;         // evaluations of the LOS condition
+			std::uint64_t invalidations = 0;  // results dropped because of a cell change
+		};
+
+		static LOSCache* GetSingleton();
+
+		// reuses results for a_ttl_ms milliseconds (the default mode)
+		void SetTTL(std::uint32_t a_ttl_ms);
+
+		// reuses results for a_ttl_frames rendered frames instead (0 = only the frame they were computed in),
+		// until SetTTL() switches back to milliseconds
+		void SetTTLFrames(std::uint32_t a_ttl_frames);
+
+		// maximum age of the results returned with a_allowStale
+		void SetStaleTTL(std::uint32_t a_staleTTL_ms);
+
+		// same as HasLOS(), but reuses a cached result if possible
+		// a_allowStale also accepts results older than the TTL (up to the stale TTL), to save raycasts
+		bool HasLOS(RE::Actor* a_observer, RE::TESObjectREFR* a_target, bool a_allowStale = false);
+
+		// drops all results with a_formID as observer or target
+		void Invalidate(RE::FormID a_formID);
+		void Clear();
+
+		[[nodiscard]] Stats GetStats() const;
+		void ResetStats();
+
+	private:
+		static constexpr std::uint32_t kSweepInterval_ms = 1000;
+
+		struct Entry
+		{
+			RE::TESObjectCELL* observerCell;
+			RE::TESObjectCELL* targetCell;
+			std::uint32_t      time;
+			std::uint32_t      frame;
+			bool               result;
+		};
+
+		// must be called with _lock held
+		[[nodiscard]] bool IsFresh(const Entry& a_entry, std::uint32_t a_now, std::uint32_t a_frame) const;
+
+		mutable std::mutex _lock;
+		std::unordered_map<std::uint64_t, Entry> _entries;  // key: observer FormID << 32 | target FormID
+		std::uint32_t _ttl = 0;
+		std::uint32_t _ttlFrames = 0;
+		bool _useFrameTTL = false;
+		std::uint32_t _staleTTL = 250;
+		std::uint32_t _lastSweep = 0;
+		Stats _stats;
+	};
+
 	int GetCombatState(RE::Actor* a_akActor);
 
     bool IsFlyingMountPatrolQueued(RE::Actor* a_akActor);
@@ -63,17 +282,261 @@ namespace _ts_SKSEFunctions {
 
 	float GetLandHeightWithWater(RE::NiPoint3& a_pos, bool a_useMaxHeight = false);
 
+	// Cache of land and water heights per exterior cell, for code sampling the terrain height many times per frame.
+	// Each cell is sampled once into a tile of kDefaultResolution x kDefaultResolution land heights (the resolution of the
+	// game's land data) plus its water height. Queries are interpolated bilinearly and don't touch the cell again.
+	// Memory is bounded by the tile capacity, the least recently used tile is evicted first.
+	class HeightfieldCache
+	{
+	public:
+		static constexpr float kCellSize = 4096.0f;
+		static constexpr std::uint32_t kDefaultResolution = 33;
+		static constexpr std::size_t kDefaultCapacity = 256;  // tiles, about 1.1 MB at the default resolution
+		static constexpr float kNoHeight = -FLT_MAX;         // SampleHeights() result for positions without a tile
+
+		// fills a_landHeights (a_resolution * a_resolution samples, row-major from the cell's south-west corner, spanning
+		// the whole cell) and a_waterHeight for a cell; returns false if the cell is not available
+		using TileSource = std::function<bool(RE::TESWorldSpace* a_worldspace, std::int32_t a_cellX, std::int32_t a_cellY,
+			std::uint32_t a_resolution, std::vector<float>& a_landHeights, float& a_waterHeight)>;
+
+		struct Stats
+		{
+			std::uint64_t hits = 0;
+			std::uint64_t misses = 0;     // tiles sampled from the tile source
+			std::uint64_t evictions = 0;
+		};
+
+		static HeightfieldCache* GetSingleton();
+
+		// samples per tile side (>= 2), changing it clears the cache
+		void SetResolution(std::uint32_t a_resolution);
+		void SetCapacity(std::size_t a_maxTiles);
+
+		// replaces the default source (GetCell() and TESWorldSpace::GetMaxHeightAt()), eg for tests; nullptr restores it
+		void SetTileSource(TileSource a_source);
+
+		// returns the interpolated height at a_x, a_y in the current (or given) worldspace
+		// with a_withWater, the height is the maximum of land and water height, like GetLandHeightWithWater()
+		std::optional<float> SampleHeight(float a_x, float a_y, bool a_withWater = true);
+		std::optional<float> SampleHeight(RE::TESWorldSpace* a_worldspace, float a_x, float a_y, bool a_withWater = true);
+
+		// same as SampleHeight(), but only answers from a tile that is already cached, it never samples the cell
+		std::optional<float> FindHeight(RE::TESWorldSpace* a_worldspace, float a_x, float a_y, bool a_withWater = true);
+
+		// batch version of SampleHeight() in the current worldspace, returns the number of sampled positions
+		// positions without a tile get kNoHeight
+		std::size_t SampleHeights(std::span<const RE::NiPoint2> a_positions, std::span<float> a_out, bool a_withWater = true);
+
+		// result of SampleHeightProfile(), clearances are the path height minus the terrain height
+		struct HeightProfile
+		{
+			float         minClearance = FLT_MAX;
+			float         maxClearance = -FLT_MAX;
+			std::size_t   sampleCount = 0;
+			std::size_t   missingSamples = 0;              // samples without a tile, not included in the clearances
+			std::optional<RE::NiPoint3> firstObstruction;  // terrain point of the first sample below the required clearance
+		};
+
+		// called for each sample along a path with the path point and the terrain height (kNoHeight if not available)
+		// return false to stop sampling
+		using ProfileCallback = std::function<bool(const RE::NiPoint3& a_point, float a_height)>;
+
+		// samples the terrain every a_step units from a_from to a_to (both included) in the current worldspace,
+		// eg to check whether a flying mount can travel in a straight line
+		HeightProfile SampleHeightProfile(const RE::NiPoint3& a_from, const RE::NiPoint3& a_to, float a_step,
+										  float a_requiredClearance = 0.0f, bool a_withWater = true);
+
+		// streaming version of SampleHeightProfile() for long paths, returns the number of visited samples
+		std::size_t SampleHeightProfile(const RE::NiPoint3& a_from, const RE::NiPoint3& a_to, float a_step,
+										const ProfileCallback& a_callback, bool a_withWater = true);
+
+		// drops all tiles, done automatically when a game is loaded
+		void Clear();
+
+		[[nodiscard]] Stats GetStats() const;
+		void ResetStats();
+
+	private:
+		struct Tile
+		{
+			std::uint64_t      key;  // worldspace FormID << 32 | cell x << 16 | cell y
+			std::vector<float> landHeights;
+			float              waterHeight = -FLT_MAX;
+		};
+
+		[[nodiscard]] static std::int32_t GetCellCoord(float a_value) { return static_cast<std::int32_t>(std::floor(a_value / kCellSize)); }
+
+		// the following must be called with _lock held.
+		// GetTile() releases a_lock while it samples a missing tile, tiles returned before may be evicted meanwhile
+		const Tile* GetTile(std::unique_lock<std::mutex>& a_lock, RE::TESWorldSpace* a_worldspace, std::int32_t a_cellX, std::int32_t a_cellY);
+		[[nodiscard]] float SampleTile(const Tile& a_tile, float a_x, float a_y, bool a_withWater) const;
+		void EvictLeastRecentlyUsed();
+		void ClearTiles();
+
+		mutable std::mutex _lock;
+		std::list<Tile> _tiles;  // most recently used first
+		std::unordered_map<std::uint64_t, std::list<Tile>::iterator> _index;
+		std::uint32_t _resolution = kDefaultResolution;
+		std::size_t _capacity = kDefaultCapacity;
+		TileSource _source;
+		std::uint64_t _generation = 0;  // advanced by ClearTiles(), tiles sampled across a clear are dropped
+		Stats _stats;
+	};
+
     bool ClearCombatTargets(RE::Actor* a_actor);
 
 	RE::Actor* GetCombatTarget(RE::Actor* a_actor);
 
+	// Watches the combat target and combat state of registered actors.
+	// Update() compares them once per frame against the values seen last and only reports the changes:
+	// - C++ callbacks, called with each Change
+	// - Papyrus events kTargetChangedEvent(Actor akActor, Actor akTarget) and kStateChangedEvent(Actor akActor, int aiState)
+	//   on the registered VM handles
+	class CombatWatcher
+	{
+	public:
+		struct Change
+		{
+			RE::Actor*  actor;
+			RE::Actor*  target;          // None if the actor lost its target
+			RE::Actor*  previousTarget;
+			std::int8_t state;           // see GetCombatState()
+			std::int8_t previousState;
+		};
+
+		using Callback = std::function<void(const Change& a_change)>;
+
+		static constexpr std::string_view kTargetChangedEvent = "OnCombatTargetChanged";
+		static constexpr std::string_view kStateChangedEvent = "OnCombatStateChanged";
+
+		static CombatWatcher* GetSingleton();
+
+		void Register(RE::Actor* a_actor);
+		void Unregister(RE::FormID a_formID);
+		void Unregister(const RE::Actor* a_actor) { if (a_actor) Unregister(a_actor->GetFormID()); }
+		void Clear();
+
+		// returns an ID for RemoveCallback()
+		std::size_t AddCallback(Callback a_callback);
+		void RemoveCallback(std::size_t a_callbackID);
+
+		void RegisterForEvents(RE::VMHandle a_handle);
+		void UnregisterForEvents(RE::VMHandle a_handle);
+
+		// compares the registered actors against their last seen state and notifies about the changes
+		// further calls in the same frame return immediately
+		void Update();
+
+	private:
+		std::mutex _lock;
+		// table of the registered actors, one entry per index
+		std::vector<RE::FormID> _formIDs;
+		std::vector<RE::ActorHandle> _handles;
+		std::vector<RE::ActorHandle> _targets;
+		std::vector<std::int8_t> _states;
+		std::vector<std::pair<std::size_t, Callback>> _callbacks;
+		std::size_t _lastCallbackID = 0;
+		std::vector<RE::VMHandle> _eventHandles;
+		std::uint32_t _lastUpdate = 0;
+	};
+
 	void UpdateCombatTarget(RE::Actor* a_actor, RE::Actor* a_target);
 
+	// Deferred version of UpdateCombatTarget() for retargeting many actors at once (eg a group of summons).
+	// Requests are collected during the frame and applied by one SKSE task on the main thread: each combat group gets
+	// one consolidated target list, and each actor one UpdateCombat(), instead of rebuilding the group per actor.
+	class CombatRetargetQueue
+	{
+	public:
+		struct Stats
+		{
+			std::uint64_t requests = 0;
+			std::uint64_t flushes = 0;
+			std::uint64_t groupRebuilds = 0;
+			std::uint64_t rebuildsAvoided = 0;     // group rebuilds UpdateCombatTarget() would have done in addition
+			std::uint64_t combatUpdates = 0;
+			std::uint64_t supersededRequests = 0;  // requests replaced by a later one for the same actor, or for invalid actors
+		};
+
+		static CombatRetargetQueue* GetSingleton();
+
+		// queues a_target as a_actor's new combat target; the last request per actor and frame wins
+		void Enqueue(RE::Actor* a_actor, RE::Actor* a_target);
+
+		// applies the queued requests, must be called on the main thread (done automatically by the queued task)
+		void Flush();
+
+		[[nodiscard]] Stats GetStats() const;
+		void ResetStats();
+
+	private:
+		struct Request
+		{
+			RE::ActorHandle actor;
+			RE::ActorHandle target;
+		};
+
+		mutable std::mutex _lock;
+		std::vector<Request> _pending;
+		bool _flushScheduled = false;
+		Stats _stats;
+	};
+
+	// calls a_func(RE::Actor*) for each member of a_actor's combat group that is still valid, without allocating
+	template <class Func>
+	void ForEachCombatMember(const RE::Actor* a_actor, Func&& a_func)
+	{
+		const auto combatGroup = a_actor ? a_actor->GetCombatGroup() : nullptr;
+		if (!combatGroup) {
+			return;
+		}
+		for (auto& memberData : combatGroup->members) {
+			if (auto member = memberData.memberHandle.get()) {
+				a_func(member.get());
+			}
+		}
+	}
+
+	// calls a_func(RE::Actor*) for each target of a_actor's combat group that is still valid, without allocating
+	template <class Func>
+	void ForEachCombatTarget(const RE::Actor* a_actor, Func&& a_func)
+	{
+		const auto combatGroup = a_actor ? a_actor->GetCombatGroup() : nullptr;
+		if (!combatGroup) {
+			return;
+		}
+		for (auto& targetData : combatGroup->targets) {
+			if (auto target = targetData.targetHandle.get()) {
+				a_func(target.get());
+			}
+		}
+	}
+
     std::vector<RE::Actor*> GetCombatMembers(const RE::Actor* a_actor);
 
+	// write the combat group members/targets into a_out and return their count
+	// if the count exceeds a_out.size(), only the first a_out.size() actors are written
+	std::size_t GetCombatMembers(const RE::Actor* a_actor, std::span<RE::Actor*> a_out);
+	std::size_t GetCombatTargets(const RE::Actor* a_actor, std::span<RE::Actor*> a_out);
+
+	// logs the members and targets of a_actor's combat group (diagnostics only)
+	void DumpCombatGroup(const RE::Actor* a_actor);
+
 	// returns the angle between two RE::NiPoint3 vectors in degrees
 	float GetAngleBetweenVectors(const RE::NiPoint3& a, const RE::NiPoint3& b);
 
+	// Tests a batch of points, given as contiguous x/y/z arrays, against the cone with apex a_apex, axis a_axis
+	// and half-angle a_angleTolerance (in degrees). Bit i of a_outMask is set if point i is inside the cone,
+	// ie if GetAngleBetweenVectors(point - a_apex, a_axis) <= a_angleTolerance.
+	// a_outMask must hold at least (count + 63) / 64 words.
+	// The tolerance is turned into a cosine threshold once, and 8 points are tested at a time (AVX2, SSE fallback).
+	void ConeFilter(std::span<const float> a_x, std::span<const float> a_y, std::span<const float> a_z,
+					const RE::NiPoint3& a_apex, const RE::NiPoint3& a_axis, float a_angleTolerance, std::span<std::uint64_t> a_outMask);
+
+	// scalar reference implementation of ConeFilter()
+	void ConeFilterScalar(std::span<const float> a_x, std::span<const float> a_y, std::span<const float> a_z,
+						  const RE::NiPoint3& a_apex, const RE::NiPoint3& a_axis, float a_angleTolerance, std::span<std::uint64_t> a_outMask);
+
 	float GetCameraYaw();
 
 	float GetCameraPitch();
@@ -93,11 +556,56 @@ namespace _ts_SKSEFunctions {
     
 	RE::NiPointer<RE::NiAVObject> GetTargetPoint(RE::Actor* a_actor, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart);
 
+	// Table of the body part coordinate frames per BGSBodyPartData and limb.
+	// The built-in vanilla/DLC mappings (kDefaultBodyPartFrames) are extended (or overridden) by the optional config
+	// file kConfigFile, so creature races added by mods can be supported without a rebuild. Its format is:
+	//     [Head]                                ; section = limb name (Torso, Head, Eye, LookAt, FlyGrab, Saddle)
+	//     MyCreatureBodyPartData = +X -Z -Y     ; BGSBodyPartData editor ID = <forward> <right> <up>
+	// Editor IDs are only resolved once per BGSBodyPartData, later lookups are keyed by FormID.
+	class BodyPartFrameTable
+	{
+	public:
+		static constexpr std::string_view kConfigFile = "SKSE/Plugins/_ts_SKSEFunctions_BodyPartFrames.ini";
+
+		// returns the table, loaded with the built-in mappings and Data/<kConfigFile> (if present)
+		static BodyPartFrameTable* GetSingleton();
+
+		// resets the table to the built-in mappings
+		void LoadDefaults();
+
+		// loads additional mappings, overriding existing ones for the same editor ID and limb.
+		// Invalid lines are logged and skipped, and make these return false
+		bool LoadFromFile(const std::filesystem::path& a_path);
+		bool LoadFromString(std::string_view a_data);
+
+		void Set(RE::BGSBodyPartDefs::LIMB_ENUM a_limb, std::string_view a_editorID, const BodyPartAxisMapping& a_mapping);
+
+		[[nodiscard]] std::optional<BodyPartAxisMapping> Find(std::string_view a_editorID, RE::BGSBodyPartDefs::LIMB_ENUM a_limb) const;
+		[[nodiscard]] std::optional<BodyPartAxisMapping> Find(const RE::BGSBodyPartData* a_bodyPartData, RE::BGSBodyPartDefs::LIMB_ENUM a_limb);
+
+	private:
+		bool Load(std::string_view a_data, std::string_view a_source);
+
+		mutable std::mutex _lock;
+		BodyPartFrameMappings _mappings;
+		std::unordered_map<RE::FormID, BodyPartLimbMappings> _byForm;  // resolved BGSBodyPartData
+	};
+
 	void GetBodyPartCoordinateFrame(RE::Actor* a_actor, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart,
                                      RE::NiPoint3& a_forward, RE::NiPoint3& a_right, RE::NiPoint3& a_up);
 
     RE::NiPoint3 GetBodyPartRotation(RE::Actor* a_actor, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart);
 
+	// Batch version of GetBodyPartRotation(): writes pitch, roll and yaw of a_bodyPart for each actor.
+	// Unless a_precise is set, the angles are computed 4 at a time with a polynomial atan2 approximation
+	// (max error of the approximation < 1e-6 rad, resulting angles within 5e-6 rad of the precise path).
+	void GetBodyPartRotations(std::span<RE::Actor* const> a_actors, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart,
+							  std::span<float> a_pitch, std::span<float> a_roll, std::span<float> a_yaw, bool a_precise = false);
+
+	// same as GetBodyPartRotations(), for pre-gathered body part frames (see GetBodyPartCoordinateFrame())
+	void GetRotationsFromFrames(std::span<const RE::NiPoint3> a_forward, std::span<const RE::NiPoint3> a_up,
+								std::span<float> a_pitch, std::span<float> a_roll, std::span<float> a_yaw, bool a_precise = false);
+
 	RE::NiPoint3 GetCameraRotation();
 	
 	/******************************************************************************************/
@@ -130,6 +638,121 @@ static float* g_deltaTimeRealTime = (float*)RELOCATION_ID(523661, 410200).addres
 
 	float SCurveFromLinear(float x, float x1, float x2);
 
+	// Snapshot of all actors in the high process list, stored as structure-of-arrays.
+	// Handles are resolved and positions, bounding spheres and flags are captured once when the snapshot is built,
+	// so the camera and crosshair queries below don't have to touch the engine for every actor on every call.
+	struct ActorSnapshot
+	{
+		enum Flag : std::uint8_t
+		{
+			kNone = 0,
+			k3DLoaded = 1 << 0,
+			kDead = 1 << 1,
+			kAlly = 1 << 2  // faction reaction towards the player is kAlly
+		};
+
+		[[nodiscard]] std::size_t size() const { return actors.size(); }
+		[[nodiscard]] bool empty() const { return actors.empty(); }
+		[[nodiscard]] bool HasFlag(std::size_t a_index, Flag a_flag) const { return (flags[a_index] & a_flag) != 0; }
+		[[nodiscard]] RE::NiPoint3 GetPosition(std::size_t a_index) const { return { posX[a_index], posY[a_index], posZ[a_index] }; }
+		[[nodiscard]] RE::NiPoint3 GetBoundCenter(std::size_t a_index) const { return { boundX[a_index], boundY[a_index], boundZ[a_index] }; }
+
+		void Clear();
+		void Reserve(std::size_t a_capacity);
+
+		std::vector<RE::ActorHandle> handles;
+		std::vector<RE::Actor*> actors;
+		std::vector<RE::FormID> formIDs;
+		std::vector<float> posX;
+		std::vector<float> posY;
+		std::vector<float> posZ;
+		// world bounding sphere of the actor's 3D (radius is 0.0f if the 3D is not loaded)
+		std::vector<float> boundX;
+		std::vector<float> boundY;
+		std::vector<float> boundZ;
+		std::vector<float> boundRadius;
+		std::vector<std::uint8_t> flags;
+
+		// grid of the actors' positions, used to only visit the actors within range of a query
+		ActorSpatialIndex spatialIndex;
+
+		RE::NiPoint3 playerPos;
+		std::uint32_t timeStamp = 0;  // application runtime (ms) of the frame the snapshot was built in
+	};
+
+	// Reusable filter for the actor queries below.
+	// Excluded actors are kept in an open-addressing set of FormIDs, so testing a candidate is O(1) instead of a linear
+	// search through an exclude list. Clearing the filter keeps its memory, so a filter can be rebuilt every frame
+	// without allocating.
+	class ActorFilter
+	{
+	public:
+		enum Flag : std::uint8_t
+		{
+			kNone = 0,
+			kRequire3D = 1 << 0,
+			kExcludeDead = 1 << 1,
+			kExcludeAllies = 1 << 2
+		};
+
+		ActorFilter() = default;
+		explicit ActorFilter(std::uint8_t a_flags, float a_maxDistance = -1.0f) { SetFlags(a_flags).SetMaxDistance(a_maxDistance); }
+
+		ActorFilter& SetFlags(std::uint8_t a_flags);
+
+		// setting a_maxDistance <= 0.0f disables the distance limit
+		ActorFilter& SetMaxDistance(float a_maxDistance);
+
+		ActorFilter& Exclude(RE::FormID a_formID);
+		ActorFilter& Exclude(const RE::Actor* a_actor);
+		ActorFilter& Exclude(std::span<RE::Actor* const> a_actors);
+
+		// removes all excluded actors, but keeps the set's memory
+		void ClearExcluded();
+
+		// makes room for a_count excluded actors, so that excluding them doesn't allocate
+		void Reserve(std::size_t a_count);
+
+		[[nodiscard]] bool IsExcluded(RE::FormID a_formID) const;
+		[[nodiscard]] bool IsExcluded(const RE::Actor* a_actor) const { return a_actor && IsExcluded(a_actor->GetFormID()); }
+
+		// tests ActorSnapshot::Flag bits against the filter flags
+		[[nodiscard]] bool AcceptsFlags(std::uint8_t a_snapshotFlags) const
+		{
+			return (a_snapshotFlags & _requiredFlags) == _requiredFlags && (a_snapshotFlags & _rejectedFlags) == 0;
+		}
+
+		[[nodiscard]] bool IsInRange(float a_distance) const { return _maxDistance <= 0.0f || a_distance <= _maxDistance; }
+
+		// tests snapshot actor a_index at a_distance from the player against all criteria of the filter
+		[[nodiscard]] bool Accepts(const ActorSnapshot& a_snapshot, std::size_t a_index, float a_distance) const
+		{
+			return AcceptsFlags(a_snapshot.flags[a_index]) && IsInRange(a_distance) && !IsExcluded(a_snapshot.formIDs[a_index]);
+		}
+
+		[[nodiscard]] std::uint8_t GetFlags() const { return _flags; }
+		[[nodiscard]] float GetMaxDistance() const { return _maxDistance; }
+		[[nodiscard]] std::size_t GetExcludedCount() const { return _excludedCount; }
+
+	private:
+		[[nodiscard]] std::size_t GetSlot(RE::FormID a_formID) const;
+		void Rehash(std::size_t a_capacity);
+
+		std::vector<RE::FormID> _excluded;  // power-of-two sized table, 0 marks an empty slot
+		std::size_t _excludedCount = 0;
+		float _maxDistance = -1.0f;
+		std::uint8_t _flags = kNone;
+		std::uint8_t _requiredFlags = 0;  // ActorSnapshot::Flag bits a candidate must have
+		std::uint8_t _rejectedFlags = 0;  // ActorSnapshot::Flag bits a candidate must not have
+	};
+
+	// returns the actor snapshot of the current frame
+	// the snapshot is rebuilt by the first call in each frame, all further calls in the same frame share that instance
+	std::shared_ptr<const ActorSnapshot> GetActorSnapshot();
+
+	// forces the next GetActorSnapshot() call to rebuild the snapshot, eg after actors have been moved or disabled
+	void InvalidateActorSnapshot();
+
 	// returns the closest living actor in the camera direction within a certain angle tolerance (in degrees) and distance
 	// setting a_maxDistance < 0.0f will search for all actors that have their 3D loaded (ie maxDistance is ignored)
 	// excludeActors is a list of actors to exclude from the search
@@ -137,15 +760,133 @@ static float* g_deltaTimeRealTime = (float*)RELOCATION_ID(523661, 410200).addres
 		float a_angleTolerance = 360.0f, 
 		float a_maxDistance = -1.0f,
 		bool a_excludeAllies = true,
-		const std::vector<RE::Actor*>& excludeActors = std::vector<RE::Actor*>());
+		std::span<RE::Actor* const> excludeActors = {});
+
+	// returns the closest actor in the camera direction within a_angleTolerance (in degrees) that passes a_filter
+	RE::Actor* FindClosestActorInCameraDirection(const ActorFilter& a_filter, float a_angleTolerance = 360.0f);
+
+
+	// ranking used by FindActorsInCameraDirection, lower scores rank first
+	struct TargetScore
+	{
+		enum class Mode
+		{
+			kDistance,  // distance to the player
+			kAngle,     // angle (in degrees) between the camera direction and the direction to the actor
+			kWeighted   // distanceWeight * distance / maxDistance + angleWeight * angle / angleTolerance
+		};
+
+		// distance range used to normalize weighted scores if the search has no distance limit
+		static constexpr float kDefaultDistanceRange = 4096.0f;
+
+		Mode mode = Mode::kDistance;
+		float distanceWeight = 1.0f;
+		float angleWeight = 1.0f;
+	};
+
+	// returns up to a_count living actors in the camera direction, sorted by a_score (best first)
+	// the search parameters are the same as for FindClosestActorInCameraDirection, but all actors are ranked in a single scan,
+	// so cycling through targets doesn't need one search per target with a growing exclude list
+	std::vector<RE::Actor*> FindActorsInCameraDirection(
+		std::size_t a_count,
+		float a_angleTolerance = 360.0f,
+		float a_maxDistance = -1.0f,
+		bool a_excludeAllies = true,
+		std::span<RE::Actor* const> excludeActors = {},
+		const TargetScore& a_score = TargetScore());
+
+	std::vector<RE::Actor*> FindActorsInCameraDirection(
+		std::size_t a_count,
+		const ActorFilter& a_filter,
+		float a_angleTolerance = 360.0f,
+		const TargetScore& a_score = TargetScore());
 
 
+	// nearest hit of a batched ray test; index is kNoHit if nothing was hit
+	struct RayHit
+	{
+		static constexpr std::size_t kNoHit = SIZE_MAX;
+
+		std::size_t index = kNoHit;
+		float       distance = FLT_MAX;
+	};
+
+	// returns the nearest of the spheres (SoA centers and radii) hit by the ray, a_rayDirection must be normalized
+	// spheres behind the ray origin are ignored, the distance is negative if the origin is inside the sphere
+	RayHit IntersectRaySpheres(const RE::NiPoint3& a_rayOrigin, const RE::NiPoint3& a_rayDirection,
+							   std::span<const float> a_centerX, std::span<const float> a_centerY, std::span<const float> a_centerZ,
+							   std::span<const float> a_radius);
+
+	// returns the nearest of the capsules (segment a-b swept by the radius) hit by the ray in front of its origin
+	RayHit IntersectRayCapsules(const RE::NiPoint3& a_rayOrigin, const RE::NiPoint3& a_rayDirection,
+								std::span<const RE::NiPoint3> a_segmentA, std::span<const RE::NiPoint3> a_segmentB,
+								std::span<const float> a_radius);
+
 	// returns the closest actor under the crosshair within a certain distance and scan angle
 	// setting a_maxTargetDistance = 0.0f will search for all actors that have their 3D loaded (ie maxTargetDistance is ignored)
 	// a_maxTargetScanAngle is the maximum angle (in degrees) from the center of the crosshair to scan for actors
 	// a_excludeActors is a list of actors to exclude from the search
 	// Note: this function also finds actors that are occluded from sight (eg behind walls)
-	RE::Actor* GetCrosshairTarget(float a_maxTargetDistance = 0.0f, float a_maxTargetScanAngle = 7.0f, std::vector<RE::Actor*> a_excludeActors = {});
+	RE::Actor* GetCrosshairTarget(float a_maxTargetDistance = 0.0f, float a_maxTargetScanAngle = 7.0f, std::span<RE::Actor* const> a_excludeActors = {});
+
+	// returns the closest actor under the crosshair within a_maxTargetScanAngle (in degrees) that passes a_filter
+	RE::Actor* GetCrosshairTarget(const ActorFilter& a_filter, float a_maxTargetScanAngle = 7.0f);
+
+	// Stateful crosshair target for polling every frame.
+	// As long as the camera stays within the thresholds of the last scan, Update() only re-validates the previous target
+	// and does a full GetCrosshairTarget() scan only once the rescan interval has elapsed or the target became invalid.
+	// A valid target is only replaced by a candidate that is nearer by more than the hysteresis fraction.
+	// Not thread-safe, use one tracker per thread.
+	class CrosshairTracker
+	{
+	public:
+		struct Settings
+		{
+			float         rotationThreshold = 1.0f;   // degrees of camera rotation that trigger a rescan
+			float         positionThreshold = 16.0f;  // units of camera movement that trigger a rescan
+			std::uint32_t rescanInterval = 250;       // ms, 0 rescans on every update
+			float         hysteresis = 0.15f;         // fraction a candidate must be nearer than the current target to replace it
+		};
+
+		struct Stats
+		{
+			std::uint64_t updates = 0;
+			std::uint64_t hits = 0;            // updates answered by re-validating the previous target
+			std::uint64_t rescans = 0;         // updates that did a full scan
+			std::uint64_t targetChanges = 0;
+			std::uint64_t revalidateTime = 0;  // microseconds spent in updates without a rescan
+			std::uint64_t rescanTime = 0;      // microseconds spent in updates with a rescan
+		};
+
+		CrosshairTracker() = default;
+		explicit CrosshairTracker(const Settings& a_settings);
+
+		// returns the tracked target, same parameters as GetCrosshairTarget()
+		RE::Actor* Update(float a_maxTargetDistance = 0.0f, float a_maxTargetScanAngle = 7.0f, std::span<RE::Actor* const> a_excludeActors = {});
+		RE::Actor* Update(const ActorFilter& a_filter, float a_maxTargetScanAngle = 7.0f);
+
+		// returns the target of the last update, without validating it
+		[[nodiscard]] RE::Actor* GetTarget() const;
+
+		// drops the target and forces a rescan on the next update
+		void Reset();
+
+		[[nodiscard]] const Settings& GetSettings() const { return _settings; }
+		void SetSettings(const Settings& a_settings) { _settings = a_settings; }
+
+		[[nodiscard]] const Stats& GetStats() const { return _stats; }
+		void ResetStats() { _stats = Stats(); }
+
+	private:
+		Settings       _settings;
+		Stats          _stats;
+		RE::ActorHandle _target;
+		float          _targetDistance = FLT_MAX;
+		RE::NiPoint3   _scanCameraPos;
+		RE::NiPoint3   _scanCameraForward;
+		std::uint32_t  _scanTime = 0;
+		bool           _hasScanned = false;
+	};
 
 
 	// Gets the cell at the given world coordinates. 
@@ -156,20 +897,108 @@ static float* g_deltaTimeRealTime = (float*)RELOCATION_ID(523661, 410200).addres
 	// Gets the cell at the given world cell index. 
 	// If the cell is not loaded, it will be loaded from disk and a_loadedFromDisk will be set to true. 
 	// If the cell is already loaded, a_loadedFromDisk will be set to false.
+	// The cells found by GetCell() are kept in a small direct-mapped cache per thread, tagged with the worldspace and
+	// cell index. It is flushed when a different worldspace is queried, when the player changes cell and when a game is
+	// loaded.
     RE::TESObjectCELL* GetCell(std::int16_t a_cellX, std::int16_t a_cellY, RE::TESWorldSpace* a_worldspace, bool& a_loadedFromDisk);
 
+	// Batch version of GetCell(): a_outCells[i] is the cell of a_cellIDs[i] (nullptr if it couldn't be loaded).
+	// Cells that have to be loaded from disk are loaded within one cancel/resume pair of the master file loads.
+	// returns the number of distinct cells successfully loaded from disk
+	std::size_t GetCells(std::span<const RE::CellID> a_cellIDs, RE::TESWorldSpace* a_worldspace, std::span<RE::TESObjectCELL*> a_outCells);
+
+	// flushes the GetCell() caches of all threads, called automatically on player cell changes and game loads
+	void InvalidateCellCache();
+
 	// Loads a grid of cells around the given center cell index into the worldspace's memory (worldspace->cellMap).
 	// The grid size is the number of cells to load in each direction from the center cell 
 	// (eg sizeX=2 will load a 5x5 grid of cells).
 	void LoadCellGrid(std::int16_t a_centerCellX, std::int16_t a_centerCellY, RE::TESWorldSpace* a_worldspace, int a_sizeX = 2, int a_sizeY = 2);
 
+	// Loads the exterior cells the player is about to reach ahead of time, instead of a whole block at once.
+	// Update() (once per frame) predicts the cells along the player's (or mount's) velocity and camera heading, queues them
+	// by the time until they are reached and loads the most urgent ones until the frame's time budget is used up.
+	class CellPrefetcher
+	{
+	public:
+		static constexpr float kCellSize = 4096.0f;
+
+		// performs the cell loads, replaceable to test the prediction and scheduling without the game
+		using ICellLoader = CellLoadQueue<RE::TESWorldSpace>::ICellLoader;
+		using Stats = CellLoadQueue<RE::TESWorldSpace>::Stats;
+
+		struct Settings
+		{
+			float         lookAheadTime = 3.0f;   // seconds of travel to predict
+			float         minSpeed = 200.0f;      // units per second, slower movement isn't prefetched
+			float         maxSpeed = 8192.0f;     // units per second, faster movement is clamped, larger jumps in Update() are teleports
+			std::size_t   maxPredictionPoints = 16;  // points per direction, the step grows to cover lookAheadTime
+			std::int32_t  radius = 1;             // cells around each predicted point
+			std::size_t   maxQueueSize = 32;
+			std::uint64_t frameBudget_us = 2000;  // load time per frame, at least one load is attempted per frame
+		};
+
+		static CellPrefetcher* GetSingleton();
+
+		[[nodiscard]] const Settings& GetSettings() const { return _settings; }
+		void SetSettings(const Settings& a_settings) { _settings = a_settings; }
+
+		// nullptr restores the loader using TESWorldSpace_LoadCell()
+		void SetLoader(std::unique_ptr<ICellLoader> a_loader);
+
+		// reads the player's movement and camera heading, then predicts and loads cells.
+		// A worldspace change, an interior or a jump faster than maxSpeed (fast travel, coc, doors) resets the movement
+		// history, the queue and the prefetched cells instead of being read as velocity. So does loading a game.
+		void Update();
+
+		// the steps of Update(), for callers providing their own movement data (a_velocity in units per second)
+		void NotifyCellEntered(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY);
+		void Predict(RE::TESWorldSpace* a_worldspace, const RE::NiPoint3& a_position, const RE::NiPoint3& a_velocity, const RE::NiPoint3& a_heading);
+		std::size_t ProcessQueue();
+
+		void Clear();
+
+		[[nodiscard]] Stats GetStats() const;
+		void ResetStats();
+
+	private:
+		CellPrefetcher();
+
+		// must be called with _lock held, drops the movement history
+		void ResetMovement();
+
+		mutable std::mutex _lock;  // movement history, the queue has its own lock
+		Settings _settings;
+		CellLoadQueue<RE::TESWorldSpace> _loads;
+		RE::NiPoint3 _lastPosition;
+		std::uint32_t _lastUpdate = 0;
+		RE::FormID _lastWorldspace = 0;
+		std::uint64_t _lastCell = 0;
+		bool _hasLastPosition = false;
+		bool _hasLastCell = false;
+	};
+
 	// Manually updates the TESGridCells structure to set the center cell to the given world cell coordinates,
 	// and populates the 5x5 grid of cells around it.
-	void UpdateTESGridCells(std::int32_t a_centerX, std::int32_t a_centerY);
-	void UpdateTESGridCells(RE::GridCellArray* a_gridCells, std::int32_t a_centerX, std::int32_t a_centerY);
+	// With a_incremental, cells of the previous grid (centered on TES::currentGridX/Y) that are still part of the new grid
+	// are shifted to their new slot, so only the newly exposed cells are resolved.
+	void UpdateTESGridCells(std::int32_t a_centerX, std::int32_t a_centerY, bool a_incremental = true);
+	void UpdateTESGridCells(RE::GridCellArray* a_gridCells, std::int32_t a_centerX, std::int32_t a_centerY, bool a_incremental = true);
 	
-	// gets all target points from the actor's 3D
-	std::vector<RE::NiPointer<RE::NiAVObject>> GetAllTargetPoints(RE::Actor* a_actor);
+	// Gets all target points from the actor's 3D.
+	// The nodes are cached per actor and only looked up again when the actor's 3D root or race changes. The span points
+	// into the cache and stays valid until the actor's entry is invalidated: its 3D or race changes, its 3D unloads,
+	// it isn't queried for a while, a game is loaded or ClearTargetPointCache() is called.
+	std::span<const RE::NiPointer<RE::NiAVObject>> GetAllTargetPoints(RE::Actor* a_actor);
+
+	// Gets the world positions of all target points of the actor's 3D, valid until the next invalidation like
+	// GetAllTargetPoints(). The positions are read from the nodes by the first query of each frame and reused by the
+	// other queries of that frame.
+	std::span<const RE::NiPoint3> GetCachedTargetPointPositions(RE::Actor* a_actor);
+
+	// releases all cached target point nodes on the main thread.
+	// Done automatically when an actor's 3D unloads and when a game is loaded
+	void ClearTargetPointCache();
 
 	// call a global papyrus function from C++
     template <class ... Args>
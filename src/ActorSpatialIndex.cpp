@@ -0,0 +1,50 @@
+#include "ActorSpatialIndex.h"
+
+namespace _ts_SKSEFunctions {
+	void ActorSpatialIndex::Clear() {
+		for (auto& [key, indices] : _buckets) {
+			indices.clear();
+		}
+	}
+
+	void ActorSpatialIndex::Build(std::span<const float> a_x, std::span<const float> a_y) {
+		Clear();
+
+		const std::size_t count = std::min(a_x.size(), a_y.size());
+		for (std::size_t i = 0; i < count; ++i) {
+			_buckets[GetKey(GetCellCoord(a_x[i]), GetCellCoord(a_y[i]))].push_back(static_cast<std::uint32_t>(i));
+		}
+
+		std::erase_if(_buckets, [](const auto& a_bucket) { return a_bucket.second.empty(); });
+	}
+
+	void ActorSpatialIndex::Insert(std::uint32_t a_index, float a_x, float a_y) {
+		_buckets[GetKey(GetCellCoord(a_x), GetCellCoord(a_y))].push_back(a_index);
+	}
+
+	void ActorSpatialIndex::Remove(std::uint32_t a_index, float a_x, float a_y) {
+		const auto it = _buckets.find(GetKey(GetCellCoord(a_x), GetCellCoord(a_y)));
+		if (it == _buckets.end()) {
+			return;
+		}
+
+		auto& indices = it->second;
+		const auto index = std::find(indices.begin(), indices.end(), a_index);
+		if (index != indices.end()) {
+			*index = indices.back();
+			indices.pop_back();
+		}
+	}
+
+	void ActorSpatialIndex::Update(std::uint32_t a_index, float a_oldX, float a_oldY, float a_newX, float a_newY) {
+		if (GetCellCoord(a_oldX) == GetCellCoord(a_newX) && GetCellCoord(a_oldY) == GetCellCoord(a_newY)) {
+			return;
+		}
+		Remove(a_index, a_oldX, a_oldY);
+		Insert(a_index, a_newX, a_newY);
+	}
+
+	void ActorSpatialIndex::QueryRadius(float a_centerX, float a_centerY, float a_radius, std::vector<std::uint32_t>& a_out) const {
+		ForEachInRadius(a_centerX, a_centerY, a_radius, [&](std::uint32_t a_index) { a_out.push_back(a_index); });
+	}
+}
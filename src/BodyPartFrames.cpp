@@ -0,0 +1,279 @@
+#include "BodyPartFrames.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace _ts_SKSEFunctions {
+	// Built-in coordinate frame mappings of the vanilla and DLC body part data.
+	// Different races use different rotation matrix columns for their forward direction, and the mapping can also differ
+	// between body parts of the same race. Each value lists the node axes used as <forward> <right> <up>.
+	const std::string_view kDefaultBodyPartFrames = R"(
+[Head]
+; +X: Right / +Y: Forward / +Z: Up
+AtronachFlameBodyPartData = +Y +X +Z
+AtronachFrostBodyPartData = +Y +X +Z
+AtronachStormBodyPartData = +Y +X +Z
+BenthicLurkerBodyPartData = +Y +X +Z
+DefaultBodyPartData = +Y +X +Z
+DLC2NetchBodyPartData = +Y +X +Z
+DLC2RieklingBodyPartData = +Y +X +Z
+DragonPriestBodyPartData = +Y +X +Z
+DraugrBodyPartData = +Y +X +Z
+DwarvenBallistaCenturionBodyPartData = +Y +X +Z
+DwarvenSpiderPartData = +Y +X +Z
+FalmerBodyPartData = +Y +X +Z
+GargoyleBodyPartData = +Y +X +Z
+GiantBodyPartData = +Y +X +Z
+HagravenBodyPartData = +Y +X +Z
+MudcrabPartData = +Y +X +Z
+SprigganBodyPartData = +Y +X +Z
+TrollBodyPartData = +Y +X +Z
+WerewolfBeastBodyPartData = +Y +X +Z
+WispBodyPartData = +Y +X +Z
+; +X: Up / +Y: Forward / +Z: Left
+DLC2HMDaedraPartData = +Y +Z +X
+DLC2MountedRieklingBodyPartData = +Y +Z +X
+DLC2ScribBodyPartData = +Y +Z +X
+DwarvenSphereCenturionBodyPartData = +Y +Z +X
+FrostbiteSpiderPartData = +Y +Z +X
+SlaughterfishBodyPartData = +Y +Z +X
+WitchlightBodyPartData = +Y +Z +X
+; +X: Forward / +Y: Down / +Z: Left
+BearBodyPartData = +X -Z -Y
+ChaurusBodyPartData = +X -Z -Y
+CowBodyPartData = +X -Z -Y
+DLC2DragonBodyPartData = +X -Z -Y
+DragonBodyPartData = +X -Z -Y
+MammothBodyPartData = +X -Z -Y
+SabreCatBodyPartData = +X -Z -Y
+; +X: Right / +Y: Down / +Z: Forward
+ChaurusFlyerBodyPartData = +Z +X -Y
+ChickenBodyPartData = +Z +X -Y
+DeerBodyPartData = +Z +X -Y
+DogBodyPartData = +Z +X -Y
+DwarvenSteamCenturionBodyPartData = +Z +X -Y
+GoatBodyPartData = +Z +X -Y
+HareBodyPartData = +Z +X -Y
+HorseBodyPartData = +Z +X -Y
+SkeeverBodyPartData = +Z +X -Y
+; +X: Backward / +Y: Right / +Z: Up
+IceWraithBodyPartData = -X +Y +Z
+; +X: Right / +Y: Backwards / +Z: Down
+HorkerBodyPartData = -Y +X -Z
+
+[Torso]
+; +X: Right / +Y: Forward / +Z: Up
+AtronachFlameBodyPartData = +Y +X +Z
+AtronachFrostBodyPartData = +Y +X +Z
+AtronachStormBodyPartData = +Y +X +Z
+BenthicLurkerBodyPartData = +Y +X +Z
+DefaultBodyPartData = +Y +X +Z
+DLC2NetchBodyPartData = +Y +X +Z
+DLC2RieklingBodyPartData = +Y +X +Z
+DragonPriestBodyPartData = +Y +X +Z
+DraugrBodyPartData = +Y +X +Z
+DwarvenBallistaCenturionBodyPartData = +Y +X +Z
+DwarvenSpiderPartData = +Y +X +Z
+DwarvenSteamCenturionBodyPartData = +Y +X +Z
+FalmerBodyPartData = +Y +X +Z
+GargoyleBodyPartData = +Y +X +Z
+GiantBodyPartData = +Y +X +Z
+HagravenBodyPartData = +Y +X +Z
+MudcrabPartData = +Y +X +Z
+SprigganBodyPartData = +Y +X +Z
+TrollBodyPartData = +Y +X +Z
+WerewolfBeastBodyPartData = +Y +X +Z
+WitchlightBodyPartData = +Y +X +Z
+; +X: Up / +Y: Forward / +Z: Left
+DLC2DragonBodyPartData = +Y +Z +X
+DLC2HMDaedraPartData = +Y +Z +X
+DLC2MountedRieklingBodyPartData = +Y +Z +X
+DragonBodyPartData = +Y +Z +X
+SlaughterfishBodyPartData = +Y +Z +X
+WispBodyPartData = +Y +Z +X
+; +X: Forward / +Y: Down / +Z: Left
+BearBodyPartData = +X -Z -Y
+ChaurusBodyPartData = +X -Z -Y
+CowBodyPartData = +X -Z -Y
+DLC2ScribBodyPartData = +X -Z -Y
+DwarvenSphereCenturionBodyPartData = +X -Z -Y
+MammothBodyPartData = +X -Z -Y
+SabreCatBodyPartData = +X -Z -Y
+; +X: Right / +Y: Down / +Z: Forward
+ChaurusFlyerBodyPartData = +Z +X -Y
+ChickenBodyPartData = +Z +X -Y
+DeerBodyPartData = +Z +X -Y
+DogBodyPartData = +Z +X -Y
+HareBodyPartData = +Z +X -Y
+HorkerBodyPartData = +Z +X -Y
+HorseBodyPartData = +Z +X -Y
+GoatBodyPartData = +Z +X -Y
+SkeeverBodyPartData = +Z +X -Y
+; +X: Backward / +Y: Right / +Z: Up
+IceWraithBodyPartData = -X +Y +Z
+; +X: Backward / +Y: Up / +Z: Left
+FrostbiteSpiderPartData = -X +Z +Y
+)";
+
+	std::optional<BodyPartAxisMapping> BodyPartAxisMapping::Parse(std::string_view a_text) {
+		BodyPartAxisMapping mapping;
+		std::size_t component = 0;
+		bool usedAxes[3] = { false, false, false };
+
+		std::size_t pos = 0;
+		while (pos < a_text.size()) {
+			const char c = a_text[pos];
+			if (c == ' ' || c == '\t' || c == ',') {
+				++pos;
+				continue;
+			}
+			if (component == 3) {
+				return std::nullopt;
+			}
+
+			std::int8_t sign = 1;
+			if (c == '+' || c == '-') {
+				sign = c == '-' ? -1 : 1;
+				if (++pos == a_text.size()) {
+					return std::nullopt;
+				}
+			}
+
+			const char axisChar = static_cast<char>(std::toupper(static_cast<unsigned char>(a_text[pos])));
+			if (axisChar < 'X' || axisChar > 'Z') {
+				return std::nullopt;
+			}
+			const auto axis = static_cast<std::uint8_t>(axisChar - 'X');
+			if (usedAxes[axis]) {
+				return std::nullopt;
+			}
+			usedAxes[axis] = true;
+
+			mapping.axis[component] = axis;
+			mapping.sign[component] = sign;
+			++component;
+			++pos;
+		}
+
+		if (component != 3) {
+			return std::nullopt;
+		}
+		return mapping;
+	}
+
+	std::string BodyPartAxisMapping::ToString() const {
+		std::string result;
+		for (std::size_t i = 0; i < 3; ++i) {
+			if (i > 0) {
+				result += ' ';
+			}
+			result += sign[i] < 0 ? '-' : '+';
+			result += static_cast<char>('X' + axis[i]);
+		}
+		return result;
+	}
+
+	void BodyPartAxisMapping::Apply(const float* a_rotation, float* a_forward, float* a_right, float* a_up) const {
+		float* const outputs[3] = { a_forward, a_right, a_up };
+		for (std::size_t i = 0; i < 3; ++i) {
+			const auto s = static_cast<float>(sign[i]);
+			for (std::size_t row = 0; row < 3; ++row) {
+				outputs[i][row] = a_rotation[row * 3 + axis[i]] * s;
+			}
+		}
+	}
+
+	static std::string_view Trim(std::string_view a_text) {
+		const auto first = a_text.find_first_not_of(" \t\r");
+		if (first == std::string_view::npos) {
+			return {};
+		}
+		return a_text.substr(first, a_text.find_last_not_of(" \t\r") - first + 1);
+	}
+
+	std::size_t BodyPartFrameMappings::Parse(std::string_view a_data, std::vector<std::string>* a_warnings) {
+		const auto warn = [&](std::size_t a_line, std::string_view a_message, std::string_view a_text) {
+			if (a_warnings) {
+				a_warnings->push_back("line " + std::to_string(a_line) + ": " + std::string(a_message) + " '" + std::string(a_text) + "'");
+			}
+		};
+
+		std::size_t count = 0;
+		std::size_t limb = kBodyPartLimbNames.size();  // none
+		bool inSection = false;  // the keys of an unknown section are skipped, the section was warned about already
+		std::size_t lineNumber = 0;
+		std::size_t pos = 0;
+		while (pos <= a_data.size()) {
+			const auto end = std::min(a_data.find('\n', pos), a_data.size());
+			std::string_view line = a_data.substr(pos, end - pos);
+			pos = end + 1;
+			++lineNumber;
+
+			// comments run to the end of the line
+			line = Trim(line.substr(0, line.find_first_of(";#")));
+			if (line.empty()) {
+				continue;
+			}
+
+			if (line.front() == '[') {
+				inSection = true;
+				limb = kBodyPartLimbNames.size();
+				if (line.back() != ']') {
+					warn(lineNumber, "Malformed section", line);
+					continue;
+				}
+				const std::string name = NormalizeEditorID(Trim(line.substr(1, line.size() - 2)));
+				const auto it = std::find_if(kBodyPartLimbNames.begin(), kBodyPartLimbNames.end(),
+					[&](std::string_view a_name) { return NormalizeEditorID(a_name) == name; });
+				if (it == kBodyPartLimbNames.end()) {
+					warn(lineNumber, "Unknown body part section", line);
+					continue;
+				}
+				limb = static_cast<std::size_t>(std::distance(kBodyPartLimbNames.begin(), it));
+				continue;
+			}
+
+			const auto separator = line.find('=');
+			const std::string_view key = separator != std::string_view::npos ? Trim(line.substr(0, separator)) : std::string_view{};
+			if (key.empty()) {
+				warn(lineNumber, "Expected '<editor ID> = <forward> <right> <up>', got", line);
+				continue;
+			}
+			if (limb == kBodyPartLimbNames.size()) {
+				if (!inSection) {
+					warn(lineNumber, "Mapping outside of a body part section", line);
+				}
+				continue;
+			}
+
+			const std::string_view value = Trim(line.substr(separator + 1));
+			const auto mapping = BodyPartAxisMapping::Parse(value);
+			if (!mapping) {
+				warn(lineNumber, "Invalid axis mapping", line);
+				continue;
+			}
+			Set(limb, key, *mapping);
+			++count;
+		}
+
+		return count;
+	}
+
+	void BodyPartFrameMappings::Set(std::size_t a_limb, std::string_view a_editorID, const BodyPartAxisMapping& a_mapping) {
+		if (a_limb >= kBodyPartLimbNames.size()) {
+			return;
+		}
+		_byEditorID[NormalizeEditorID(a_editorID)][a_limb] = a_mapping;
+	}
+
+	const BodyPartLimbMappings* BodyPartFrameMappings::Find(std::string_view a_editorID) const {
+		const auto it = _byEditorID.find(NormalizeEditorID(a_editorID));
+		return it != _byEditorID.end() ? &it->second : nullptr;
+	}
+
+	std::string BodyPartFrameMappings::NormalizeEditorID(std::string_view a_editorID) {
+		std::string result(a_editorID);
+		std::transform(result.begin(), result.end(), result.begin(), [](unsigned char a_c) { return static_cast<char>(std::tolower(a_c)); });
+		return result;
+	}
+}
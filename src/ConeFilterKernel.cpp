@@ -0,0 +1,152 @@
+#include "ConeFilterKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+#endif
+
+namespace _ts_SKSEFunctions {
+	// A point p is inside the cone if dot(p - apex, axis) >= cos(tolerance) * |p - apex| (axis normalized),
+	// which is equivalent to GetAngleBetweenVectors(p - apex, axis) <= tolerance but needs no acos per point.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#define TS_TARGET_AVX2
+#else
+	#define TS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+	bool HasAVX2Support() {
+		static const bool hasAVX2 = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) {
+				return false;
+			}
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+				return false;
+			}
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}();
+		return hasAVX2;
+	}
+
+	bool GetConeParams(float a_apexX, float a_apexY, float a_apexZ, float a_axisX, float a_axisY, float a_axisZ,
+					   float a_angleTolerance, ConeParams& a_params, bool& a_allInside) {
+		const float axisLength = std::sqrt(a_axisX * a_axisX + a_axisY * a_axisY + a_axisZ * a_axisZ);
+		if (a_angleTolerance < 0.0f) {
+			a_allInside = false;
+			return false;
+		}
+		// GetAngleBetweenVectors() returns 0 for a zero axis, and no angle exceeds 180 degrees
+		if (axisLength == 0.0f || a_angleTolerance >= 180.0f) {
+			a_allInside = true;
+			return false;
+		}
+
+		a_params.apexX = a_apexX;
+		a_params.apexY = a_apexY;
+		a_params.apexZ = a_apexZ;
+		a_params.axisX = a_axisX / axisLength;
+		a_params.axisY = a_axisY / axisLength;
+		a_params.axisZ = a_axisZ / axisLength;
+		a_params.cosThreshold = std::cos(a_angleTolerance * 3.1415926535f / 180.0f);
+		return true;
+	}
+
+	static void ConeFilterRange(const float* a_x, const float* a_y, const float* a_z, std::size_t a_begin, std::size_t a_end,
+								const ConeParams& a_params, std::uint64_t* a_outMask) {
+		for (std::size_t i = a_begin; i < a_end; ++i) {
+			const float dx = a_x[i] - a_params.apexX;
+			const float dy = a_y[i] - a_params.apexY;
+			const float dz = a_z[i] - a_params.apexZ;
+			const float dot = dx * a_params.axisX + dy * a_params.axisY + dz * a_params.axisZ;
+			const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+			if (dot >= a_params.cosThreshold * length) {
+				a_outMask[i / 64] |= std::uint64_t(1) << (i % 64);
+			}
+		}
+	}
+
+	// processes blocks of 8 points as two SSE halves, returns the number of points processed
+	static std::size_t ConeFilterSSE(const float* a_x, const float* a_y, const float* a_z, std::size_t a_count,
+									 const ConeParams& a_params, std::uint64_t* a_outMask) {
+		const __m128 apexX = _mm_set1_ps(a_params.apexX);
+		const __m128 apexY = _mm_set1_ps(a_params.apexY);
+		const __m128 apexZ = _mm_set1_ps(a_params.apexZ);
+		const __m128 axisX = _mm_set1_ps(a_params.axisX);
+		const __m128 axisY = _mm_set1_ps(a_params.axisY);
+		const __m128 axisZ = _mm_set1_ps(a_params.axisZ);
+		const __m128 cosThreshold = _mm_set1_ps(a_params.cosThreshold);
+
+		auto test4 = [&](std::size_t i) {
+			const __m128 dx = _mm_sub_ps(_mm_loadu_ps(a_x + i), apexX);
+			const __m128 dy = _mm_sub_ps(_mm_loadu_ps(a_y + i), apexY);
+			const __m128 dz = _mm_sub_ps(_mm_loadu_ps(a_z + i), apexZ);
+			const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, axisX), _mm_mul_ps(dy, axisY)), _mm_mul_ps(dz, axisZ));
+			const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			return static_cast<std::uint64_t>(_mm_movemask_ps(_mm_cmpge_ps(dot, _mm_mul_ps(cosThreshold, length))));
+		};
+
+		const std::size_t blockEnd = a_count & ~std::size_t(7);
+		for (std::size_t i = 0; i < blockEnd; i += 8) {
+			const std::uint64_t bits = test4(i) | (test4(i + 4) << 4);
+			a_outMask[i / 64] |= bits << (i % 64);
+		}
+		return blockEnd;
+	}
+
+	TS_TARGET_AVX2 static std::size_t ConeFilterAVX2(const float* a_x, const float* a_y, const float* a_z, std::size_t a_count,
+													 const ConeParams& a_params, std::uint64_t* a_outMask) {
+		const __m256 apexX = _mm256_set1_ps(a_params.apexX);
+		const __m256 apexY = _mm256_set1_ps(a_params.apexY);
+		const __m256 apexZ = _mm256_set1_ps(a_params.apexZ);
+		const __m256 axisX = _mm256_set1_ps(a_params.axisX);
+		const __m256 axisY = _mm256_set1_ps(a_params.axisY);
+		const __m256 axisZ = _mm256_set1_ps(a_params.axisZ);
+		const __m256 cosThreshold = _mm256_set1_ps(a_params.cosThreshold);
+
+		const std::size_t blockEnd = a_count & ~std::size_t(7);
+		for (std::size_t i = 0; i < blockEnd; i += 8) {
+			const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(a_x + i), apexX);
+			const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(a_y + i), apexY);
+			const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(a_z + i), apexZ);
+			const __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, axisX), _mm256_mul_ps(dy, axisY)), _mm256_mul_ps(dz, axisZ));
+			const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+			const auto bits = static_cast<std::uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(dot, _mm256_mul_ps(cosThreshold, length), _CMP_GE_OQ)));
+			a_outMask[i / 64] |= bits << (i % 64);
+		}
+		return blockEnd;
+	}
+
+	void ConeFilterPoints(const float* a_x, const float* a_y, const float* a_z, std::size_t a_count,
+						  const ConeParams& a_params, std::uint64_t* a_outMask, bool a_vectorized) {
+		std::fill_n(a_outMask, (a_count + 63) / 64, std::uint64_t(0));
+
+		std::size_t processed = 0;
+		if (a_vectorized) {
+			processed = HasAVX2Support() ?
+				ConeFilterAVX2(a_x, a_y, a_z, a_count, a_params, a_outMask) :
+				ConeFilterSSE(a_x, a_y, a_z, a_count, a_params, a_outMask);
+		}
+		ConeFilterRange(a_x, a_y, a_z, processed, a_count, a_params, a_outMask);
+	}
+
+	void FillConeMask(std::size_t a_count, bool a_allInside, std::uint64_t* a_outMask) {
+		const std::size_t wordCount = (a_count + 63) / 64;
+		std::fill_n(a_outMask, wordCount, a_allInside ? ~std::uint64_t(0) : 0);
+		if (a_allInside && a_count % 64 != 0) {
+			a_outMask[wordCount - 1] = (std::uint64_t(1) << (a_count % 64)) - 1;
+		}
+	}
+}
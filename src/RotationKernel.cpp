@@ -0,0 +1,112 @@
+#include "RotationKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+namespace _ts_SKSEFunctions {
+	constexpr float kPi = 3.1415926535f;
+
+	// Polynomial approximation of atan2 for 4 lanes (Abramowitz & Stegun 4.4.49 on [0, 1] plus octant reduction).
+	// Maximum absolute error is below 1e-6 radians over the full input range; atan2(0, 0) returns 0.
+	static __m128 Atan2Approx(__m128 a_y, __m128 a_x) {
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 absY = _mm_andnot_ps(signMask, a_y);
+		const __m128 absX = _mm_andnot_ps(signMask, a_x);
+
+		const __m128 maxAbs = _mm_max_ps(absX, absY);
+		const __m128 minAbs = _mm_min_ps(absX, absY);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 safeMax = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(maxAbs, zero), maxAbs), _mm_andnot_ps(_mm_cmpgt_ps(maxAbs, zero), _mm_set1_ps(1.0f)));
+		const __m128 a = _mm_div_ps(minAbs, safeMax);
+		const __m128 s = _mm_mul_ps(a, a);
+
+		__m128 r = _mm_set1_ps(0.0028662257f);
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.0161657367f));
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.0429096138f));
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.0752896400f));
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.1065626393f));
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.1420889944f));
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.1999355085f));
+		r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.3333314528f));
+		r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, s), a), a);
+
+		// undo the octant reduction: swap of x and y, negative x, negative y
+		const __m128 swapped = _mm_cmpgt_ps(absY, absX);
+		r = _mm_or_ps(_mm_and_ps(swapped, _mm_sub_ps(_mm_set1_ps(0.5f * kPi), r)), _mm_andnot_ps(swapped, r));
+		const __m128 negativeX = _mm_cmplt_ps(a_x, zero);
+		r = _mm_or_ps(_mm_and_ps(negativeX, _mm_sub_ps(_mm_set1_ps(kPi), r)), _mm_andnot_ps(negativeX, r));
+		return _mm_or_ps(r, _mm_and_ps(signMask, a_y));
+	}
+
+	void RotationFromFrame(const float* a_forward, const float* a_up, float& a_pitch, float& a_roll, float& a_yaw) {
+		float yaw = std::atan2(a_forward[0], a_forward[1]);
+		float pitch = std::asin(std::clamp(-a_forward[2], -1.0f, 1.0f));
+
+		// Compute roll from the up vector's deviation from world up
+		// Project the up vector onto the plane perpendicular to forward
+		// Then measure its rotation relative to the expected "up" direction
+		float cosPitch = std::cos(pitch);
+		float sinPitch = std::sin(pitch);
+		float cosYaw = std::cos(yaw);
+		float sinYaw = std::sin(yaw);
+
+		// Expected up vector (world +Z rotated by pitch and yaw only, zero roll)
+		const float expectedUp[3] = { -sinPitch * sinYaw, -sinPitch * cosYaw, cosPitch };
+
+		// Expected right vector (perpendicular to both forward and expectedUp)
+		const float expectedRight[3] = { cosYaw, -sinYaw, 0.0f };
+
+		// Project actual up vector onto the expectedUp and expectedRight to get roll angle
+		float upDotExpectedUp = a_up[0] * expectedUp[0] + a_up[1] * expectedUp[1] + a_up[2] * expectedUp[2];
+		float upDotExpectedRight = a_up[0] * expectedRight[0] + a_up[1] * expectedRight[1] + a_up[2] * expectedRight[2];
+
+		a_pitch = pitch;
+		a_roll = -std::atan2(upDotExpectedRight, upDotExpectedUp);
+		a_yaw = yaw;
+	}
+
+	void RotationsFromFrames(const float* a_forward, const float* a_up, std::size_t a_count,
+							 float* a_pitch, float* a_roll, float* a_yaw, bool a_precise) {
+		std::size_t i = 0;
+		if (!a_precise) {
+			// The sines and cosines of pitch and yaw follow directly from the forward vector:
+			//   sin(yaw) = fx / h, cos(yaw) = fy / h, sin(pitch) = -fz, cos(pitch) = sqrt(1 - fz^2), with h = |(fx, fy)|
+			// so all three angles reduce to an atan2, evaluated 4 lanes at a time.
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 zero = _mm_setzero_ps();
+			for (; i + 4 <= a_count; i += 4) {
+				const float* f = a_forward + 3 * i;
+				const float* u = a_up + 3 * i;
+				const __m128 fx = _mm_setr_ps(f[0], f[3], f[6], f[9]);
+				const __m128 fy = _mm_setr_ps(f[1], f[4], f[7], f[10]);
+				const __m128 fz = _mm_min_ps(_mm_max_ps(_mm_setr_ps(f[2], f[5], f[8], f[11]), _mm_set1_ps(-1.0f)), one);
+				const __m128 ux = _mm_setr_ps(u[0], u[3], u[6], u[9]);
+				const __m128 uy = _mm_setr_ps(u[1], u[4], u[7], u[10]);
+				const __m128 uz = _mm_setr_ps(u[2], u[5], u[8], u[11]);
+
+				const __m128 h = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy)));
+				// atan2(0, 0) = 0, ie sin(yaw) = 0 and cos(yaw) = 1 for a vertical forward vector
+				const __m128 horizontal = _mm_cmpgt_ps(h, zero);
+				const __m128 invH = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(horizontal, h), _mm_andnot_ps(horizontal, one)));
+				const __m128 sinYaw = _mm_and_ps(horizontal, _mm_mul_ps(fx, invH));
+				const __m128 cosYaw = _mm_or_ps(_mm_and_ps(horizontal, _mm_mul_ps(fy, invH)), _mm_andnot_ps(horizontal, one));
+				const __m128 sinPitch = _mm_sub_ps(zero, fz);
+				const __m128 cosPitch = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(fz, fz)), zero));
+
+				const __m128 upDotExpectedUp = _mm_add_ps(
+					_mm_mul_ps(_mm_sub_ps(zero, sinPitch), _mm_add_ps(_mm_mul_ps(sinYaw, ux), _mm_mul_ps(cosYaw, uy))),
+					_mm_mul_ps(cosPitch, uz));
+				const __m128 upDotExpectedRight = _mm_sub_ps(_mm_mul_ps(cosYaw, ux), _mm_mul_ps(sinYaw, uy));
+
+				_mm_storeu_ps(a_yaw + i, Atan2Approx(fx, fy));
+				_mm_storeu_ps(a_pitch + i, Atan2Approx(sinPitch, cosPitch));
+				_mm_storeu_ps(a_roll + i, _mm_sub_ps(zero, Atan2Approx(upDotExpectedRight, upDotExpectedUp)));
+			}
+		}
+
+		for (; i < a_count; ++i) {
+			RotationFromFrame(a_forward + 3 * i, a_up + 3 * i, a_pitch[i], a_roll[i], a_yaw[i]);
+		}
+	}
+}
@@ -1,8 +1,20 @@
 #include "SKSE/logger.h"
 #include "_ts_SKSEFunctions.h"
+#include "ConeFilterKernel.h"
+#include "EditorIDCache.h"
 #include "Offsets.h"
+#include "RotationKernel.h"
 #include "CLIBUtil/EditorID.hpp"
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <fstream>
+#include <immintrin.h>
+#include <mutex>
+#include <numeric>
+#include <span>
+
 namespace _ts_SKSEFunctions {
 
 	void InitializeLogging(spdlog::level::level_enum a_loglevel) {
@@ -29,6 +41,61 @@ namespace _ts_SKSEFunctions {
 		spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%l] [%t] [%s:%#] %v");
 	}
 
+/******************************************************************************************/
+
+	class LoadGameEventSink : public RE::BSTEventSink<RE::TESLoadGameEvent>
+	{
+	public:
+		static LoadGameEventSink* GetSingleton() {
+			static LoadGameEventSink singleton;
+			return &singleton;
+		}
+
+		void AddCallback(void (*a_callback)()) {
+			std::call_once(_registered, [this]() {
+				if (auto* eventSource = RE::ScriptEventSourceHolder::GetSingleton()) {
+					eventSource->AddEventSink<RE::TESLoadGameEvent>(this);
+				}
+			});
+
+			std::lock_guard lock(_lock);
+			if (std::find(_callbacks.begin(), _callbacks.end(), a_callback) == _callbacks.end()) {
+				_callbacks.push_back(a_callback);
+			}
+		}
+
+		RE::BSEventNotifyControl ProcessEvent(const RE::TESLoadGameEvent*, RE::BSTEventSource<RE::TESLoadGameEvent>*) override {
+			std::vector<void (*)()> callbacks;
+			{
+				std::lock_guard lock(_lock);
+				callbacks = _callbacks;
+			}
+			for (const auto callback : callbacks) {
+				callback();
+			}
+			return RE::BSEventNotifyControl::kContinue;
+		}
+
+	private:
+		std::once_flag _registered;
+		std::mutex _lock;
+		std::vector<void (*)()> _callbacks;
+	};
+
+	void AddLoadGameCallback(void (*a_callback)()) {
+		if (a_callback) {
+			LoadGameEventSink::GetSingleton()->AddCallback(a_callback);
+		}
+	}
+
+/******************************************************************************************/
+
+	// number of frames rendered so far, for TTLs that shouldn't depend on the frame rate
+	static std::uint32_t GetFrameCount() {
+		const auto* state = RE::BSGraphics::State::GetSingleton();
+		return state ? state->frameCount : 0;
+	}
+
 /******************************************************************************************/
 
 	// Function to pause a while loop if the game is in menu mode, console is open, or out of focus
@@ -244,6 +311,63 @@ namespace _ts_SKSEFunctions {
 
 /******************************************************************************************/
 
+	static EditorIDCache<RE::TESForm*>& GetEditorIDCache() {
+		static EditorIDCache<RE::TESForm*> cache;
+		// forms created or deleted by the loaded game invalidate both the found and the unknown editor IDs
+		[[maybe_unused]] static const bool registered = (AddLoadGameCallback(ClearEditorIDCache), true);
+		return cache;
+	}
+
+	static RE::TESForm* ResolveEditorID(std::string_view a_editorID) {
+		return RE::TESForm::LookupByEditorID(a_editorID);
+	}
+
+	RE::TESForm* LookupFormByEditorID(std::string_view a_editorID) {
+		return GetEditorIDCache().Lookup(a_editorID, ResolveEditorID);
+	}
+
+	std::size_t WarmEditorIDCache(std::span<const std::string_view> a_editorIDs) {
+		return GetEditorIDCache().Warm(a_editorIDs, ResolveEditorID);
+	}
+
+	void ClearEditorIDCache() {
+		GetEditorIDCache().Clear();
+	}
+
+/******************************************************************************************/
+
+	// Sorted FormIDs of the packages in a BGSListForm, so membership tests are a binary search instead of a walk over
+	// the list. An entry is rebuilt when the list's forms differ from the ones it was built from: comparing the form
+	// pointers is a memcmp, much cheaper than the type checks and the sort, and also catches forms replaced in place.
+	struct PackageListCacheEntry
+	{
+		std::vector<RE::TESForm*> forms;  // the list's forms the entry was built from
+		std::vector<RE::FormID> packages;
+	};
+
+	static std::mutex g_packageListCacheLock;
+	static std::unordered_map<RE::FormID, PackageListCacheEntry> g_packageListCache;
+
+	// returns the up-to-date package FormIDs of a_packageList, must be called with g_packageListCacheLock held
+	static const std::vector<RE::FormID>& GetPackageListFormIDs(const RE::BGSListForm* a_packageList) {
+		// FormIDs of lists and packages created by the game may be reused by the next loaded game
+		[[maybe_unused]] static const bool registered = (AddLoadGameCallback(ClearPackageListCache), true);
+
+		auto& entry = g_packageListCache[a_packageList->GetFormID()];
+		const auto& forms = a_packageList->forms;
+		if (!std::equal(entry.forms.begin(), entry.forms.end(), forms.begin(), forms.end())) {
+			entry.forms.assign(forms.begin(), forms.end());
+			entry.packages.clear();
+			for (auto* form : forms) {
+				if (form && form->Is(RE::FormType::Package)) {
+					entry.packages.push_back(form->GetFormID());
+				}
+			}
+			std::sort(entry.packages.begin(), entry.packages.end());
+		}
+		return entry.packages;
+	}
+
 	bool CheckForPackage(RE::Actor* a_akActor, const RE::BGSListForm* a_Packagelist, RE::TESPackage* a_CheckPackage) {
 		if (!a_akActor) {
 			spdlog::error("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
@@ -256,20 +380,170 @@ namespace _ts_SKSEFunctions {
 
 		if (!a_CheckPackage) {
 			a_CheckPackage = a_akActor->GetCurrentPackage();
+			if (!a_CheckPackage) {
+				return false;
+			}
 		}
 
-		for (auto& form : a_Packagelist->forms) {
-			if (form && form->As<RE::TESPackage>() == a_CheckPackage) {
-				return true;
+		std::lock_guard lock(g_packageListCacheLock);
+		const auto& packages = GetPackageListFormIDs(a_Packagelist);
+		return std::binary_search(packages.begin(), packages.end(), a_CheckPackage->GetFormID());
+	}
+
+	void CheckForPackage(std::span<RE::Actor* const> a_actors, const RE::BGSListForm* a_Packagelist, std::span<std::uint64_t> a_outMask) {
+		const std::size_t wordCount = std::min(a_outMask.size(), (a_actors.size() + 63) / 64);
+		std::fill_n(a_outMask.begin(), wordCount, 0);
+		if (!a_Packagelist) {
+			return;
+		}
+
+		std::lock_guard lock(g_packageListCacheLock);
+		const auto& packages = GetPackageListFormIDs(a_Packagelist);
+		for (std::size_t i = 0; i < std::min(a_actors.size(), wordCount * 64); ++i) {
+			auto* actor = a_actors[i];
+			auto* package = actor ? actor->GetCurrentPackage() : nullptr;
+			if (package && std::binary_search(packages.begin(), packages.end(), package->GetFormID())) {
+				a_outMask[i / 64] |= std::uint64_t(1) << (i % 64);
+			}
+		}
+	}
+
+	void ClearPackageListCache() {
+		std::lock_guard lock(g_packageListCacheLock);
+		g_packageListCache.clear();
+	}
+
+/******************************************************************************************/
+
+	std::uint64_t ConditionDescriptor::GetKey() const {
+		return static_cast<std::uint64_t>(function) |
+			static_cast<std::uint64_t>(opCode) << 16 |
+			static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(comparisonValue)) << 32;
+	}
+
+	RE::TESCondition* ConditionCache::Get(const ConditionDescriptor& a_descriptor) {
+		// one set of instances per thread: their params are set right before evaluating, so they must not be shared
+		thread_local std::unordered_map<std::uint64_t, std::unique_ptr<RE::TESCondition>> conditions;
+
+		auto& condition = conditions[a_descriptor.GetKey()];
+		if (!condition) {
+			spdlog::debug("_ts_SKSEFunctions - {}: creating condition for function {}", __func__, static_cast<std::uint32_t>(a_descriptor.function));
+			auto* conditionItem = new RE::TESConditionItem;
+			conditionItem->data.comparisonValue.f = a_descriptor.comparisonValue;
+			conditionItem->data.flags.opCode = a_descriptor.opCode;
+			conditionItem->data.functionData.function = a_descriptor.function;
+
+			condition.reset(new RE::TESCondition);
+			condition->head = conditionItem;
+		}
+		return condition.get();
+	}
+
+	bool EvaluateCondition(const ConditionDescriptor& a_descriptor, RE::TESObjectREFR* a_subject, void* a_param0, void* a_param1) {
+		auto* condition = ConditionCache::Get(a_descriptor);
+		condition->head->data.functionData.params[0] = a_param0;
+		condition->head->data.functionData.params[1] = a_param1;
+		return condition->IsTrue(a_subject, nullptr);
+	}
+
+	// returns the script command implementing condition function a_function, or nullptr if it has no condition function
+	static const RE::SCRIPT_FUNCTION* GetConditionCommand(RE::FUNCTION_DATA::FunctionID a_function) {
+		// condition function IDs index the script commands
+		const auto index = static_cast<std::uint32_t>(a_function);
+		if (index >= RE::SCRIPT_FUNCTION::Commands::kScriptCommandsEnd) {
+			return nullptr;
+		}
+
+		const auto* command = RE::SCRIPT_FUNCTION::GetFirstScriptCommand() + index;
+		return command->conditionFunction ? command : nullptr;
+	}
+
+	std::optional<double> EvaluateConditionValue(RE::FUNCTION_DATA::FunctionID a_function, RE::TESObjectREFR* a_subject, void* a_param0, void* a_param1) {
+		const auto* command = GetConditionCommand(a_function);
+		if (!command) {
+			return std::nullopt;
+		}
+
+		double result = 0.0;
+		if (!command->conditionFunction(a_subject, a_param0, a_param1, result)) {
+			return std::nullopt;
+		}
+		return result;
+	}
+
+/******************************************************************************************/
+
+	// The batch evaluations resolve the condition (or condition function) and set its parameters once, then only
+	// test each subject. a_getSubject(i) returns the i-th subject, or nullptr to skip it.
+	template <class GetSubject>
+	static void EvaluateConditionsImpl(const ConditionDescriptor& a_descriptor, std::size_t a_count, GetSubject&& a_getSubject,
+									   std::span<std::uint64_t> a_outMask, void* a_param0, void* a_param1) {
+		const std::size_t wordCount = std::min(a_outMask.size(), (a_count + 63) / 64);
+		std::fill_n(a_outMask.begin(), wordCount, 0);
+		if (a_count > wordCount * 64) {
+			spdlog::error("_ts_SKSEFunctions - {}: a_outMask holds {} words, {} are needed", __func__, a_outMask.size(), (a_count + 63) / 64);
+			a_count = wordCount * 64;
+		}
+
+		auto* condition = ConditionCache::Get(a_descriptor);
+		condition->head->data.functionData.params[0] = a_param0;
+		condition->head->data.functionData.params[1] = a_param1;
+
+		for (std::size_t i = 0; i < a_count; ++i) {
+			auto* subject = a_getSubject(i);
+			if (subject && condition->IsTrue(subject, nullptr)) {
+				a_outMask[i / 64] |= std::uint64_t(1) << (i % 64);
 			}
 		}
+	}
+
+	template <class GetSubject>
+	static void EvaluateConditionValuesImpl(RE::FUNCTION_DATA::FunctionID a_function, std::size_t a_count, GetSubject&& a_getSubject,
+											std::span<int> a_out, void* a_param0, void* a_param1, int a_invalidValue) {
+		if (a_count > a_out.size()) {
+			spdlog::error("_ts_SKSEFunctions - {}: a_out holds {} values, {} are needed", __func__, a_out.size(), a_count);
+			a_count = a_out.size();
+		}
+
+		const auto* command = GetConditionCommand(a_function);
+		for (std::size_t i = 0; i < a_count; ++i) {
+			auto* subject = a_getSubject(i);
+			double result = 0.0;
+			a_out[i] = command && subject && command->conditionFunction(subject, a_param0, a_param1, result) ?
+				static_cast<int>(result) : a_invalidValue;
+		}
+	}
+
+	void EvaluateConditions(const ConditionDescriptor& a_descriptor, std::span<RE::Actor* const> a_actors, std::span<std::uint64_t> a_outMask,
+							void* a_param0, void* a_param1) {
+		EvaluateConditionsImpl(a_descriptor, a_actors.size(),
+			[&](std::size_t i) { return IsFormValid(a_actors[i]) ? a_actors[i] : nullptr; },
+			a_outMask, a_param0, a_param1);
+	}
+
+	void EvaluateConditions(const ConditionDescriptor& a_descriptor, const ActorSnapshot& a_snapshot, std::span<std::uint64_t> a_outMask,
+							void* a_param0, void* a_param1) {
+		EvaluateConditionsImpl(a_descriptor, a_snapshot.size(),
+			[&](std::size_t i) { return a_snapshot.actors[i]; },
+			a_outMask, a_param0, a_param1);
+	}
+
+	void EvaluateConditionValues(RE::FUNCTION_DATA::FunctionID a_function, std::span<RE::Actor* const> a_actors, std::span<int> a_out,
+								 void* a_param0, void* a_param1, int a_invalidValue) {
+		EvaluateConditionValuesImpl(a_function, a_actors.size(),
+			[&](std::size_t i) { return IsFormValid(a_actors[i]) ? a_actors[i] : nullptr; },
+			a_out, a_param0, a_param1, a_invalidValue);
+	}
 
-		return false;
+	void EvaluateConditionValues(RE::FUNCTION_DATA::FunctionID a_function, const ActorSnapshot& a_snapshot, std::span<int> a_out,
+								 void* a_param0, void* a_param1, int a_invalidValue) {
+		EvaluateConditionValuesImpl(a_function, a_snapshot.size(),
+			[&](std::size_t i) { return a_snapshot.actors[i]; },
+			a_out, a_param0, a_param1, a_invalidValue);
 	}
 
 /******************************************************************************************/
 
-	RE::TESCondition* condition_IsPlayerInRegion;
 	bool IsPlayerInRegion(const std::string& a_regionName) {
 	
 		auto player = RE::PlayerCharacter::GetSingleton();
@@ -279,78 +553,171 @@ namespace _ts_SKSEFunctions {
 			return false;
 		}
 	
-		if (!condition_IsPlayerInRegion) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating IsPlayerInBorderRegion condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-		   
-			conditionItem->data.comparisonValue.f = 1.0f;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kIsPlayerInRegion;
-			condition_IsPlayerInRegion = new RE::TESCondition;
-			condition_IsPlayerInRegion->head = conditionItem;
-		}
-	
-		auto* regionForm =  RE::TESForm::LookupByEditorID(a_regionName);
+		auto* regionForm = LookupFormByEditorID(a_regionName);
 		if (!regionForm) {
 			spdlog::error("_ts_SKSEFunctions - {}: Failed to lookup region form {}", __func__, a_regionName);
 			return false;
 		}
-		condition_IsPlayerInRegion->head->data.functionData.params[0] = regionForm;
 	
-		return condition_IsPlayerInRegion->IsTrue(player, nullptr);
+		return EvaluateCondition(Conditions::kIsPlayerInRegion, player, regionForm);
 	}
 	
+/******************************************************************************************/
+
+	RegionTracker* RegionTracker::GetSingleton() {
+		static RegionTracker singleton;
+		return &singleton;
+	}
+
+	bool RegionTracker::AddRegion(std::string_view a_editorID) {
+		std::lock_guard lock(_lock);
+		if (FindRegion(a_editorID)) {
+			return true;
+		}
+
+		auto* region = LookupFormByEditorID<RE::TESRegion>(a_editorID);
+		if (!region) {
+			spdlog::error("_ts_SKSEFunctions - {}: Failed to lookup region form {}", __func__, a_editorID);
+			return false;
+		}
+
+		_regions.push_back({ std::string(a_editorID), region, false });
+		_dirty = true;
+		return true;
+	}
+
+	void RegionTracker::RemoveRegion(std::string_view a_editorID) {
+		std::lock_guard lock(_lock);
+		std::erase_if(_regions, [&](const TrackedRegion& a_region) { return a_region.editorID == a_editorID; });
+	}
+
+	void RegionTracker::Clear() {
+		std::lock_guard lock(_lock);
+		_regions.clear();
+		_lastCell = nullptr;
+		_dirty = true;
+	}
+
+	std::size_t RegionTracker::AddCallback(Callback a_callback) {
+		std::lock_guard lock(_lock);
+		_callbacks.emplace_back(++_lastCallbackID, std::move(a_callback));
+		return _lastCallbackID;
+	}
+
+	void RegionTracker::RemoveCallback(std::size_t a_callbackID) {
+		std::lock_guard lock(_lock);
+		std::erase_if(_callbacks, [a_callbackID](const auto& a_item) { return a_item.first == a_callbackID; });
+	}
+
+	void RegionTracker::RegisterForEvents(RE::VMHandle a_handle) {
+		std::lock_guard lock(_lock);
+		if (a_handle && std::find(_eventHandles.begin(), _eventHandles.end(), a_handle) == _eventHandles.end()) {
+			_eventHandles.push_back(a_handle);
+		}
+	}
+
+	void RegionTracker::UnregisterForEvents(RE::VMHandle a_handle) {
+		std::lock_guard lock(_lock);
+		std::erase(_eventHandles, a_handle);
+	}
+
+	void RegionTracker::Update(bool a_force) {
+		auto* player = RE::PlayerCharacter::GetSingleton();
+		if (!player) {
+			return;
+		}
+
+		struct Change
+		{
+			RE::TESRegion* region;
+			std::string    editorID;
+			bool           entered;
+		};
+		std::vector<Change> changes;
+		std::vector<Callback> callbacks;
+		std::vector<RE::VMHandle> eventHandles;
+		{
+			std::lock_guard lock(_lock);
+			auto* cell = player->GetParentCell();
+			if (cell == _lastCell && !_dirty && !a_force) {
+				return;
+			}
+			_lastCell = cell;
+			_dirty = false;
+
+			for (auto& tracked : _regions) {
+				const bool inside = cell && EvaluateCondition(Conditions::kIsPlayerInRegion, player, tracked.region);
+				if (inside != tracked.inside) {
+					tracked.inside = inside;
+					changes.push_back({ tracked.region, tracked.editorID, inside });
+				}
+			}
+			if (changes.empty()) {
+				return;
+			}
+
+			for (const auto& [id, callback] : _callbacks) {
+				callbacks.push_back(callback);
+			}
+			eventHandles = _eventHandles;
+		}
+
+		// dispatched without holding the lock, so callbacks can query or change the tracker
+		for (const auto& change : changes) {
+			for (const auto& callback : callbacks) {
+				callback(change.region, change.editorID, change.entered);
+			}
+			for (const auto handle : eventHandles) {
+				SendCustomEvent(handle, std::string(change.entered ? kEnterEvent : kExitEvent),
+					RE::MakeFunctionArguments(RE::BSFixedString(change.editorID)));
+			}
+		}
+	}
+
+	bool RegionTracker::IsPlayerInRegion(std::string_view a_editorID) {
+		if (!AddRegion(a_editorID)) {
+			return false;
+		}
+		Update();
+
+		std::lock_guard lock(_lock);
+		const auto* tracked = FindRegion(a_editorID);
+		return tracked && tracked->inside;
+	}
+
+	RegionTracker::TrackedRegion* RegionTracker::FindRegion(std::string_view a_editorID) {
+		const auto it = std::find_if(_regions.begin(), _regions.end(), [&](const TrackedRegion& a_region) { return a_region.editorID == a_editorID; });
+		return it != _regions.end() ? &*it : nullptr;
+	}
+
 /******************************************************************************************/
 	
-	RE::TESCondition* condition_GetFlyingState;
 	int GetFlyingState(RE::Actor* a_akActor) {
 		if (!IsFormValid(a_akActor)) {
 			spdlog::warn("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
 			return -1;
 		}
 
-		if (!condition_GetFlyingState) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating GetFlyingState condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kGetFlyingState;
-
-			condition_GetFlyingState = new RE::TESCondition;
-			condition_GetFlyingState->head = conditionItem;
-		}
-
-		for (int i = 0; i < 6; i++) {
-			condition_GetFlyingState->head->data.comparisonValue.f = i;
-			if (condition_GetFlyingState->IsTrue(a_akActor, nullptr)) {
-				return i;
-			}
+		const auto state = EvaluateConditionValue(RE::FUNCTION_DATA::FunctionID::kGetFlyingState, a_akActor);
+		if (!state || *state < 0.0 || *state >= 6.0) {
+			return -1;
 		}
-		return -1;
+		return static_cast<int>(*state);
 	}
 
 /******************************************************************************************/
 
-	RE::TESCondition* condition_GetIsFlying;
 	bool IsFlying(RE::Actor* a_akActor) {
 		if (!IsFormValid(a_akActor)) {
 			spdlog::warn("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
 			return false;
 		}
 
-		if (!condition_GetIsFlying) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating GetIsFlying condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-			conditionItem->data.comparisonValue.f = 1.0f;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kGetIsFlying;
-
-			condition_GetIsFlying = new RE::TESCondition;
-			condition_GetIsFlying->head = conditionItem;
-		}
-
-		return condition_GetIsFlying->IsTrue(a_akActor, nullptr);
+		return EvaluateCondition(Conditions::kGetIsFlying, a_akActor);
 	}
 
 /******************************************************************************************/
 
-	RE::TESCondition* condition_HasLOS;
 	bool HasLOS(RE::Actor* a_akActor, RE::TESObjectREFR* a_target) {
 		if (!IsFormValid(a_akActor)) {
 			spdlog::warn("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
@@ -362,89 +729,142 @@ namespace _ts_SKSEFunctions {
 			return false;
 		}
 
-		if (!condition_HasLOS) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating HasLOS condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-			conditionItem->data.comparisonValue.f = 1.0f;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kGetLineOfSight;
+		return EvaluateCondition(Conditions::kGetLineOfSight, a_akActor, a_target);
+	}
+
+/******************************************************************************************/
 
-			condition_HasLOS = new RE::TESCondition;
-			condition_HasLOS->head = conditionItem;
+	LOSCache* LOSCache::GetSingleton() {
+		static LOSCache singleton;
+		return &singleton;
+	}
+
+	void LOSCache::SetTTL(std::uint32_t a_ttl_ms) {
+		std::lock_guard lock(_lock);
+		_ttl = a_ttl_ms;
+		_useFrameTTL = false;
+	}
+
+	void LOSCache::SetTTLFrames(std::uint32_t a_ttl_frames) {
+		std::lock_guard lock(_lock);
+		_ttlFrames = a_ttl_frames;
+		_useFrameTTL = true;
+	}
+
+	bool LOSCache::IsFresh(const Entry& a_entry, std::uint32_t a_now, std::uint32_t a_frame) const {
+		return _useFrameTTL ? a_frame - a_entry.frame <= _ttlFrames : a_now - a_entry.time <= _ttl;
+	}
+
+	void LOSCache::SetStaleTTL(std::uint32_t a_staleTTL_ms) {
+		std::lock_guard lock(_lock);
+		_staleTTL = a_staleTTL_ms;
+	}
+
+	bool LOSCache::HasLOS(RE::Actor* a_observer, RE::TESObjectREFR* a_target, bool a_allowStale) {
+		if (!IsFormValid(a_observer)) {
+			spdlog::warn("_ts_SKSEFunctions - {}: error, a_observer doesn't exist", __func__);
+			return false;
+		}
+
+		if (!IsFormValid(a_target)) {
+			spdlog::warn("_ts_SKSEFunctions - {}: error, a_target doesn't exist", __func__);
+			return false;
 		}
 
-		condition_HasLOS->head->data.functionData.params[0] = a_target;
-		return condition_HasLOS->IsTrue(a_akActor, nullptr);
+		const std::uint64_t key = static_cast<std::uint64_t>(a_observer->GetFormID()) << 32 | a_target->GetFormID();
+		auto* observerCell = a_observer->GetParentCell();
+		auto* targetCell = a_target->GetParentCell();
+		const std::uint32_t now = RE::GetDurationOfApplicationRunTime();
+		const std::uint32_t frame = GetFrameCount();
+
+		{
+			std::lock_guard lock(_lock);
+			if (const auto it = _entries.find(key); it != _entries.end()) {
+				const auto& entry = it->second;
+				if (entry.observerCell != observerCell || entry.targetCell != targetCell) {
+					++_stats.invalidations;
+				} else if (IsFresh(entry, now, frame)) {
+					++_stats.hits;
+					return entry.result;
+				} else if (a_allowStale && now - entry.time <= _staleTTL) {
+					++_stats.staleHits;
+					return entry.result;
+				}
+			}
+			++_stats.misses;
+		}
+
+		// evaluated without holding the lock, the raycast is by far the most expensive part
+		const bool result = EvaluateCondition(Conditions::kGetLineOfSight, a_observer, a_target);
+
+		std::lock_guard lock(_lock);
+		if (now - _lastSweep > kSweepInterval_ms) {
+			std::erase_if(_entries, [&](const auto& a_item) {
+				return !IsFresh(a_item.second, now, frame) && now - a_item.second.time > _staleTTL;
+			});
+			_lastSweep = now;
+		}
+		_entries[key] = Entry{ observerCell, targetCell, now, frame, result };
+		return result;
+	}
+
+	void LOSCache::Invalidate(RE::FormID a_formID) {
+		std::lock_guard lock(_lock);
+		std::erase_if(_entries, [a_formID](const auto& a_item) {
+			return static_cast<RE::FormID>(a_item.first >> 32) == a_formID || static_cast<RE::FormID>(a_item.first) == a_formID;
+		});
+	}
+
+	void LOSCache::Clear() {
+		std::lock_guard lock(_lock);
+		_entries.clear();
+	}
+
+	LOSCache::Stats LOSCache::GetStats() const {
+		std::lock_guard lock(_lock);
+		return _stats;
+	}
+
+	void LOSCache::ResetStats() {
+		std::lock_guard lock(_lock);
+		_stats = Stats();
 	}
 
 /******************************************************************************************/
 
-	RE::TESCondition* condition_GetCombatState;
 	int GetCombatState(RE::Actor* a_akActor) {
 		if (!IsFormValid(a_akActor)) {
 			spdlog::warn("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
 			return -1;
 		}
 
-		if (!condition_GetCombatState) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating GetCombatState condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kGetCombatState;
-
-			condition_GetCombatState = new RE::TESCondition;
-			condition_GetCombatState->head = conditionItem;
-		}
-
-		for (int i = 0; i < 3; i++) {
-				condition_GetCombatState->head->data.comparisonValue.f = i;
-			if (condition_GetCombatState->IsTrue(a_akActor, nullptr)) {
-				return i;
-			}
+		const auto state = EvaluateConditionValue(RE::FUNCTION_DATA::FunctionID::kGetCombatState, a_akActor);
+		if (!state || *state < 0.0 || *state >= 3.0) {
+			return -1;
 		}
-		return -1;
+		return static_cast<int>(*state);
 	}
 
 /******************************************************************************************/
 	
-	RE::TESCondition* condition_IsFlyingMountPatrolQueued;
 	bool IsFlyingMountPatrolQueued(RE::Actor* a_akActor) {
 		if (!IsFormValid(a_akActor)) {
 			spdlog::warn("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
 			return false;
 		}
 
-		if (!condition_IsFlyingMountPatrolQueued) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating IsFlyingMountPatrolQueued condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-			conditionItem->data.comparisonValue.f = 1.0f;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kIsFlyingMountPatrolQueued;
-
-			condition_IsFlyingMountPatrolQueued = new RE::TESCondition;
-			condition_IsFlyingMountPatrolQueued->head = conditionItem;
-		}
-
-		return condition_IsFlyingMountPatrolQueued->IsTrue(a_akActor, nullptr);
+		return EvaluateCondition(Conditions::kIsFlyingMountPatrolQueued, a_akActor);
 	}
 
 /******************************************************************************************/
 	
-	RE::TESCondition* condition_IsFlyingMountFastTravelling;
 	bool IsFlyingMountFastTravelling(RE::Actor* a_akActor) {
 		if (!IsFormValid(a_akActor)) {
 			spdlog::warn("_ts_SKSEFunctions - {}: error, a_akActor doesn't exist", __func__);
 			return false;
 		}
 
-		if (!condition_IsFlyingMountFastTravelling) {
-			spdlog::info("_ts_SKSEFunctions - {}: creating IsFlyingMountFastTravelling condition", __func__);
-			auto* conditionItem = new RE::TESConditionItem;
-			conditionItem->data.comparisonValue.f = 1.0f;
-			conditionItem->data.functionData.function = RE::FUNCTION_DATA::FunctionID::kIsFlyingMountFastTravelling;
-
-			condition_IsFlyingMountFastTravelling = new RE::TESCondition;
-			condition_IsFlyingMountFastTravelling->head = conditionItem;
-		}
-
-		return condition_IsFlyingMountFastTravelling->IsTrue(a_akActor, nullptr);
+		return EvaluateCondition(Conditions::kIsFlyingMountFastTravelling, a_akActor);
 	}
 
 /******************************************************************************************/
@@ -479,7 +899,7 @@ namespace _ts_SKSEFunctions {
 			success = worldspace->GetMaxHeightAt(pos, heightOut);
 		}
 
-		spdlog::info("_ts_SKSEFunctions - {}: height: {}", __func__, heightOut);
+		spdlog::debug("_ts_SKSEFunctions - {}: height: {}", __func__, heightOut);
 		return heightOut;
 	}
 
@@ -557,73 +977,526 @@ namespace _ts_SKSEFunctions {
 
 /******************************************************************************************/
 
-	bool ClearCombatTargets(RE::Actor* a_actor)
-	{
-		if (!a_actor) {
-			return false;
-		}
+	// key of an exterior cell: worldspace FormID << 32 | cell x << 16 | cell y
+	static std::uint64_t GetExteriorCellKey(RE::FormID a_worldspaceID, std::int32_t a_cellX, std::int32_t a_cellY) {
+		return static_cast<std::uint64_t>(a_worldspaceID) << 32 |
+			static_cast<std::uint64_t>(static_cast<std::uint16_t>(a_cellX)) << 16 | static_cast<std::uint16_t>(a_cellY);
+	}
 
-		auto combatGroup = a_actor->GetCombatGroup();
-		if (!combatGroup) {
+	// bilinear interpolation in a tile of a_resolution x a_resolution samples spanning the cell, a_localX/Y in [0, cell size]
+	static float SampleTileHeights(const std::vector<float>& a_heights, std::uint32_t a_resolution, float a_localX, float a_localY) {
+		const float scale = static_cast<float>(a_resolution - 1) / HeightfieldCache::kCellSize;
+		const float fx = std::clamp(a_localX * scale, 0.0f, static_cast<float>(a_resolution - 1));
+		const float fy = std::clamp(a_localY * scale, 0.0f, static_cast<float>(a_resolution - 1));
+		const std::uint32_t x0 = std::min(static_cast<std::uint32_t>(fx), a_resolution - 2);
+		const std::uint32_t y0 = std::min(static_cast<std::uint32_t>(fy), a_resolution - 2);
+		const float tx = fx - static_cast<float>(x0);
+		const float ty = fy - static_cast<float>(y0);
+
+		const float* row0 = a_heights.data() + static_cast<std::size_t>(y0) * a_resolution + x0;
+		const float* row1 = row0 + a_resolution;
+		const float bottom = row0[0] + (row0[1] - row0[0]) * tx;
+		const float top = row1[0] + (row1[1] - row1[0]) * tx;
+		return bottom + (top - bottom) * ty;
+	}
+
+	// default tile source: loads the cell like GetLandHeight() and samples GetMaxHeightAt() on the tile grid
+	static bool LoadHeightfieldTileFromWorld(RE::TESWorldSpace* a_worldspace, std::int32_t a_cellX, std::int32_t a_cellY,
+											 std::uint32_t a_resolution, std::vector<float>& a_landHeights, float& a_waterHeight) {
+		bool loadedFromDisk = false;
+		auto* cell = GetCell(static_cast<std::int16_t>(a_cellX), static_cast<std::int16_t>(a_cellY), a_worldspace, loadedFromDisk);
+		if (!cell) {
 			return false;
 		}
 
-		int i = 0;
-		for (auto& targetData : combatGroup->targets) {
-			auto target = targetData.targetHandle.get();
-			i++;
-		}
-		
-		combatGroup->targets.clear();
-		a_actor->SetCombatGroup(combatGroup);
+		const float originX = static_cast<float>(a_cellX) * HeightfieldCache::kCellSize;
+		const float originY = static_cast<float>(a_cellY) * HeightfieldCache::kCellSize;
+		const float spacing = HeightfieldCache::kCellSize / static_cast<float>(a_resolution - 1);
+		// samples on the far edges are moved inside by a unit, so they are taken from this cell as well
+		const float maxOffset = HeightfieldCache::kCellSize - 1.0f;
 
+		for (std::uint32_t y = 0; y < a_resolution; ++y) {
+			for (std::uint32_t x = 0; x < a_resolution; ++x) {
+				RE::NiPoint3 pos(originX + std::min(static_cast<float>(x) * spacing, maxOffset),
+								 originY + std::min(static_cast<float>(y) * spacing, maxOffset), 0.0f);
+				float height = -1.0f;
+				a_worldspace->GetMaxHeightAt(pos, height);
+				a_landHeights[static_cast<std::size_t>(y) * a_resolution + x] = height;
+			}
+		}
+		a_waterHeight = cell->GetExteriorWaterHeight();
 		return true;
 	}
 
-/******************************************************************************************/
+	HeightfieldCache* HeightfieldCache::GetSingleton() {
+		static HeightfieldCache singleton;
+		// the tiles of the previous game's cells may be outdated, and a new game may reuse worldspace FormIDs
+		[[maybe_unused]] static const bool registered = (AddLoadGameCallback([]() { GetSingleton()->Clear(); }), true);
+		return &singleton;
+	}
 
-	std::vector<RE::Actor*> GetCombatMembers(const RE::Actor* a_actor)
-	{
-		std::vector<RE::Actor*> result;
+	void HeightfieldCache::SetResolution(std::uint32_t a_resolution) {
+		std::lock_guard lock(_lock);
+		a_resolution = std::max(a_resolution, 2u);
+		if (a_resolution != _resolution) {
+			_resolution = a_resolution;
+			ClearTiles();
+		}
+	}
 
-		if (!a_actor) {
-			spdlog::info("_ts_SKSEFunctions - {}: a_actor is None", __func__);
-			return result;
+	void HeightfieldCache::SetCapacity(std::size_t a_maxTiles) {
+		std::lock_guard lock(_lock);
+		_capacity = std::max<std::size_t>(a_maxTiles, 1);
+		while (_tiles.size() > _capacity) {
+			EvictLeastRecentlyUsed();
 		}
+	}
 
-		spdlog::info("_ts_SKSEFunctions - {}", __func__);
-		int i = 0;
-		if (const auto combatGroup = a_actor->GetCombatGroup()) {
-			for (auto& memberData : combatGroup->members) {
-				auto member = memberData.memberHandle.get();
-				spdlog::info("_ts_SKSEFunctions - {}: member[{}]: {}", __func__, i, member.get()->GetFormID());	
-				if (member) {
-					result.push_back(member.get());
-				}
-				i++;
-			}
-		}	
-		i = 0;
-		if (const auto combatGroup = a_actor->GetCombatGroup()) {
-			for (auto& targetData : combatGroup->targets) {
-				auto target = targetData.targetHandle.get();
-				spdlog::info("_ts_SKSEFunctions - {}: target[{}]: {}", __func__, i, target.get()->GetFormID());	
+	void HeightfieldCache::SetTileSource(TileSource a_source) {
+		std::lock_guard lock(_lock);
+		_source = std::move(a_source);
+		ClearTiles();
+	}
 
-				i++;
-			}
-		}
+	void HeightfieldCache::Clear() {
+		std::lock_guard lock(_lock);
+		ClearTiles();
+	}
 
-		return result;
+	void HeightfieldCache::ClearTiles() {
+		_tiles.clear();
+		_index.clear();
+		++_generation;
 	}
 
-/******************************************************************************************/
+	HeightfieldCache::Stats HeightfieldCache::GetStats() const {
+		std::lock_guard lock(_lock);
+		return _stats;
+	}
 
-	RE::Actor* GetCombatTarget(RE::Actor* a_actor) {
-		if (!a_actor) {
+	void HeightfieldCache::ResetStats() {
+		std::lock_guard lock(_lock);
+		_stats = Stats();
+	}
+
+	void HeightfieldCache::EvictLeastRecentlyUsed() {
+		_index.erase(_tiles.back().key);
+		_tiles.pop_back();
+		++_stats.evictions;
+	}
+
+	const HeightfieldCache::Tile* HeightfieldCache::GetTile(std::unique_lock<std::mutex>& a_lock, RE::TESWorldSpace* a_worldspace,
+															  std::int32_t a_cellX, std::int32_t a_cellY) {
+		const std::uint64_t key = GetExteriorCellKey(a_worldspace->GetFormID(), a_cellX, a_cellY);
+
+		if (const auto it = _index.find(key); it != _index.end()) {
+			++_stats.hits;
+			_tiles.splice(_tiles.begin(), _tiles, it->second);  // most recently used first
+			return &*it->second;
+		}
+
+		++_stats.misses;
+		// the tile is sampled without the lock (a GetCell() plus resolution^2 height queries), so queries of cached tiles
+		// on other threads don't wait for it
+		const std::uint32_t resolution = _resolution;
+		const std::uint64_t generation = _generation;
+		const TileSource source = _source;
+		a_lock.unlock();
+
+		Tile tile;
+		tile.key = key;
+		tile.landHeights.resize(static_cast<std::size_t>(resolution) * resolution);
+		const bool loaded = source ?
+			source(a_worldspace, a_cellX, a_cellY, resolution, tile.landHeights, tile.waterHeight) :
+			LoadHeightfieldTileFromWorld(a_worldspace, a_cellX, a_cellY, resolution, tile.landHeights, tile.waterHeight);
+
+		a_lock.lock();
+		// a clear (game load, new resolution or source) while sampling makes the tile outdated
+		if (!loaded || generation != _generation) {
 			return nullptr;
 		}
+		if (const auto it = _index.find(key); it != _index.end()) {
+			// another thread sampled the same cell meanwhile
+			_tiles.splice(_tiles.begin(), _tiles, it->second);
+			return &*it->second;
+		}
 
-		auto targetHandle = a_actor->GetActorRuntimeData().currentCombatTarget;
+		if (_tiles.size() >= _capacity) {
+			EvictLeastRecentlyUsed();
+		}
+		_tiles.push_front(std::move(tile));
+		_index[key] = _tiles.begin();
+		return &_tiles.front();
+	}
+
+	float HeightfieldCache::SampleTile(const Tile& a_tile, float a_x, float a_y, bool a_withWater) const {
+		const float localX = a_x - std::floor(a_x / kCellSize) * kCellSize;
+		const float localY = a_y - std::floor(a_y / kCellSize) * kCellSize;
+		const float height = SampleTileHeights(a_tile.landHeights, _resolution, localX, localY);
+		return a_withWater ? std::max(height, a_tile.waterHeight) : height;
+	}
+
+	std::optional<float> HeightfieldCache::SampleHeight(float a_x, float a_y, bool a_withWater) {
+		auto* tes = RE::TES::GetSingleton();
+		auto* worldspace = tes ? tes->GetRuntimeData2().worldSpace : nullptr;
+		if (!worldspace) {
+			return std::nullopt;
+		}
+		return SampleHeight(worldspace, a_x, a_y, a_withWater);
+	}
+
+	std::optional<float> HeightfieldCache::SampleHeight(RE::TESWorldSpace* a_worldspace, float a_x, float a_y, bool a_withWater) {
+		if (!a_worldspace) {
+			return std::nullopt;
+		}
+
+		std::unique_lock lock(_lock);
+		const auto* tile = GetTile(lock, a_worldspace, GetCellCoord(a_x), GetCellCoord(a_y));
+		if (!tile) {
+			return std::nullopt;
+		}
+		return SampleTile(*tile, a_x, a_y, a_withWater);
+	}
+
+	std::optional<float> HeightfieldCache::FindHeight(RE::TESWorldSpace* a_worldspace, float a_x, float a_y, bool a_withWater) {
+		if (!a_worldspace) {
+			return std::nullopt;
+		}
+
+		std::lock_guard lock(_lock);
+		const auto it = _index.find(GetExteriorCellKey(a_worldspace->GetFormID(), GetCellCoord(a_x), GetCellCoord(a_y)));
+		if (it == _index.end()) {
+			return std::nullopt;
+		}
+		++_stats.hits;
+		_tiles.splice(_tiles.begin(), _tiles, it->second);
+		return SampleTile(*it->second, a_x, a_y, a_withWater);
+	}
+
+	std::size_t HeightfieldCache::SampleHeights(std::span<const RE::NiPoint2> a_positions, std::span<float> a_out, bool a_withWater) {
+		auto* tes = RE::TES::GetSingleton();
+		auto* worldspace = tes ? tes->GetRuntimeData2().worldSpace : nullptr;
+		const std::size_t count = std::min(a_positions.size(), a_out.size());
+		if (!worldspace) {
+			std::fill_n(a_out.begin(), count, kNoHeight);
+			return 0;
+		}
+
+		std::size_t sampled = 0;
+		std::unique_lock lock(_lock);
+		// consecutive positions are usually in the same cell, so the tile is only looked up when the cell changes
+		const Tile* tile = nullptr;
+		bool hasTile = false;
+		std::int32_t tileX = 0;
+		std::int32_t tileY = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			const auto& pos = a_positions[i];
+			const std::int32_t cellX = GetCellCoord(pos.x);
+			const std::int32_t cellY = GetCellCoord(pos.y);
+			if (!hasTile || cellX != tileX || cellY != tileY) {
+				tile = GetTile(lock, worldspace, cellX, cellY);
+				hasTile = true;
+				tileX = cellX;
+				tileY = cellY;
+			}
+			if (tile) {
+				a_out[i] = SampleTile(*tile, pos.x, pos.y, a_withWater);
+				++sampled;
+			} else {
+				a_out[i] = kNoHeight;
+			}
+		}
+		return sampled;
+	}
+
+	std::size_t HeightfieldCache::SampleHeightProfile(const RE::NiPoint3& a_from, const RE::NiPoint3& a_to, float a_step,
+													  const ProfileCallback& a_callback, bool a_withWater) {
+		const RE::NiPoint3 delta = a_to - a_from;
+		const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+		const std::size_t steps = a_step > 0.0f ? std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(length / a_step))) : 1;
+
+		// sampled in chunks, so callbacks run without holding the lock and no buffer for the whole path is needed
+		constexpr std::size_t kChunkSize = 64;
+		std::array<RE::NiPoint2, kChunkSize> positions;
+		std::array<float, kChunkSize> heights;
+
+		std::size_t visited = 0;
+		for (std::size_t first = 0; first <= steps; first += kChunkSize) {
+			const std::size_t count = std::min(kChunkSize, steps + 1 - first);
+			for (std::size_t i = 0; i < count; ++i) {
+				const float t = static_cast<float>(first + i) / static_cast<float>(steps);
+				positions[i] = { a_from.x + delta.x * t, a_from.y + delta.y * t };
+			}
+			SampleHeights(std::span(positions.data(), count), std::span(heights.data(), count), a_withWater);
+
+			for (std::size_t i = 0; i < count; ++i) {
+				const float t = static_cast<float>(first + i) / static_cast<float>(steps);
+				++visited;
+				if (!a_callback(RE::NiPoint3(positions[i].x, positions[i].y, a_from.z + delta.z * t), heights[i])) {
+					return visited;
+				}
+			}
+		}
+		return visited;
+	}
+
+	HeightfieldCache::HeightProfile HeightfieldCache::SampleHeightProfile(const RE::NiPoint3& a_from, const RE::NiPoint3& a_to, float a_step,
+																		  float a_requiredClearance, bool a_withWater) {
+		HeightProfile profile;
+		SampleHeightProfile(a_from, a_to, a_step, [&](const RE::NiPoint3& a_point, float a_height) {
+			++profile.sampleCount;
+			if (a_height == kNoHeight) {
+				++profile.missingSamples;
+				return true;
+			}
+
+			const float clearance = a_point.z - a_height;
+			profile.minClearance = std::min(profile.minClearance, clearance);
+			profile.maxClearance = std::max(profile.maxClearance, clearance);
+			if (clearance < a_requiredClearance && !profile.firstObstruction) {
+				profile.firstObstruction = RE::NiPoint3(a_point.x, a_point.y, a_height);
+			}
+			return true;
+		}, a_withWater);
+		return profile;
+	}
+
+/******************************************************************************************/
+
+	bool ClearCombatTargets(RE::Actor* a_actor)
+	{
+		if (!a_actor) {
+			return false;
+		}
+
+		auto combatGroup = a_actor->GetCombatGroup();
+		if (!combatGroup) {
+			return false;
+		}
+
+		int i = 0;
+		for (auto& targetData : combatGroup->targets) {
+			auto target = targetData.targetHandle.get();
+			i++;
+		}
+		
+		combatGroup->targets.clear();
+		a_actor->SetCombatGroup(combatGroup);
+
+		return true;
+	}
+
+/******************************************************************************************/
+
+	std::vector<RE::Actor*> GetCombatMembers(const RE::Actor* a_actor)
+	{
+		std::vector<RE::Actor*> result;
+		ForEachCombatMember(a_actor, [&](RE::Actor* a_member) { result.push_back(a_member); });
+		return result;
+	}
+
+	std::size_t GetCombatMembers(const RE::Actor* a_actor, std::span<RE::Actor*> a_out)
+	{
+		std::size_t count = 0;
+		ForEachCombatMember(a_actor, [&](RE::Actor* a_member) {
+			if (count < a_out.size()) {
+				a_out[count] = a_member;
+			}
+			++count;
+		});
+		return count;
+	}
+
+	std::size_t GetCombatTargets(const RE::Actor* a_actor, std::span<RE::Actor*> a_out)
+	{
+		std::size_t count = 0;
+		ForEachCombatTarget(a_actor, [&](RE::Actor* a_target) {
+			if (count < a_out.size()) {
+				a_out[count] = a_target;
+			}
+			++count;
+		});
+		return count;
+	}
+
+	void DumpCombatGroup(const RE::Actor* a_actor)
+	{
+		if (!a_actor) {
+			spdlog::info("_ts_SKSEFunctions - {}: a_actor is None", __func__);
+			return;
+		}
+
+		const auto combatGroup = a_actor->GetCombatGroup();
+		if (!combatGroup) {
+			spdlog::info("_ts_SKSEFunctions - {}: actor {:08X} is not in a combat group", __func__, a_actor->GetFormID());
+			return;
+		}
+
+		spdlog::info("_ts_SKSEFunctions - {}: combat group of actor {:08X}: {} members, {} targets", __func__, a_actor->GetFormID(),
+			combatGroup->members.size(), combatGroup->targets.size());
+		int i = 0;
+		for (auto& memberData : combatGroup->members) {
+			auto member = memberData.memberHandle.get();
+			spdlog::info("_ts_SKSEFunctions - {}: member[{}]: {:08X}", __func__, i++, member ? member->GetFormID() : 0);
+		}
+		i = 0;
+		for (auto& targetData : combatGroup->targets) {
+			auto target = targetData.targetHandle.get();
+			spdlog::info("_ts_SKSEFunctions - {}: target[{}]: {:08X}", __func__, i++, target ? target->GetFormID() : 0);
+		}
+	}
+
+/******************************************************************************************/
+
+	CombatWatcher* CombatWatcher::GetSingleton() {
+		static CombatWatcher singleton;
+		return &singleton;
+	}
+
+	void CombatWatcher::Register(RE::Actor* a_actor) {
+		if (!IsFormValid(a_actor)) {
+			spdlog::warn("_ts_SKSEFunctions - {}: error, a_actor doesn't exist", __func__);
+			return;
+		}
+
+		std::lock_guard lock(_lock);
+		const auto formID = a_actor->GetFormID();
+		if (std::find(_formIDs.begin(), _formIDs.end(), formID) != _formIDs.end()) {
+			return;
+		}
+
+		// start from the current state, only later changes are reported
+		_formIDs.push_back(formID);
+		_handles.push_back(a_actor->GetHandle());
+		_targets.push_back(a_actor->GetActorRuntimeData().currentCombatTarget);
+		_states.push_back(static_cast<std::int8_t>(GetCombatState(a_actor)));
+	}
+
+	void CombatWatcher::Unregister(RE::FormID a_formID) {
+		std::lock_guard lock(_lock);
+		const auto it = std::find(_formIDs.begin(), _formIDs.end(), a_formID);
+		if (it == _formIDs.end()) {
+			return;
+		}
+
+		// swap with the last entry, the order of the table doesn't matter
+		const auto i = static_cast<std::size_t>(it - _formIDs.begin());
+		const auto last = _formIDs.size() - 1;
+		_formIDs[i] = _formIDs[last];
+		_handles[i] = _handles[last];
+		_targets[i] = _targets[last];
+		_states[i] = _states[last];
+		_formIDs.pop_back();
+		_handles.pop_back();
+		_targets.pop_back();
+		_states.pop_back();
+	}
+
+	void CombatWatcher::Clear() {
+		std::lock_guard lock(_lock);
+		_formIDs.clear();
+		_handles.clear();
+		_targets.clear();
+		_states.clear();
+	}
+
+	std::size_t CombatWatcher::AddCallback(Callback a_callback) {
+		std::lock_guard lock(_lock);
+		_callbacks.emplace_back(++_lastCallbackID, std::move(a_callback));
+		return _lastCallbackID;
+	}
+
+	void CombatWatcher::RemoveCallback(std::size_t a_callbackID) {
+		std::lock_guard lock(_lock);
+		std::erase_if(_callbacks, [a_callbackID](const auto& a_item) { return a_item.first == a_callbackID; });
+	}
+
+	void CombatWatcher::RegisterForEvents(RE::VMHandle a_handle) {
+		std::lock_guard lock(_lock);
+		if (a_handle && std::find(_eventHandles.begin(), _eventHandles.end(), a_handle) == _eventHandles.end()) {
+			_eventHandles.push_back(a_handle);
+		}
+	}
+
+	void CombatWatcher::UnregisterForEvents(RE::VMHandle a_handle) {
+		std::lock_guard lock(_lock);
+		std::erase(_eventHandles, a_handle);
+	}
+
+	void CombatWatcher::Update() {
+		// only used under the lock, the changes are a local, as callbacks may call Update() again while they are dispatched
+		thread_local std::vector<RE::Actor*> actors;
+		thread_local std::vector<int> states;
+
+		std::vector<Change> changes;
+		std::vector<Callback> callbacks;
+		std::vector<RE::VMHandle> eventHandles;
+		{
+			std::lock_guard lock(_lock);
+			const std::uint32_t now = RE::GetDurationOfApplicationRunTime();
+			if (now == _lastUpdate) {
+				return;
+			}
+			_lastUpdate = now;
+
+			actors.resize(_handles.size());
+			for (std::size_t i = 0; i < _handles.size(); ++i) {
+				actors[i] = _handles[i].get().get();
+			}
+			states.resize(actors.size());
+			EvaluateConditionValues(RE::FUNCTION_DATA::FunctionID::kGetCombatState, actors, states);
+
+			for (std::size_t i = 0; i < actors.size(); ++i) {
+				auto* actor = actors[i];
+				if (!actor) {
+					// unloaded actors keep their last state until they are loaded again
+					continue;
+				}
+
+				const auto target = actor->GetActorRuntimeData().currentCombatTarget;
+				const auto state = static_cast<std::int8_t>(states[i]);
+				if (target == _targets[i] && state == _states[i]) {
+					continue;
+				}
+
+				changes.push_back({ actor, target.get().get(), _targets[i].get().get(), state, _states[i] });
+				_targets[i] = target;
+				_states[i] = state;
+			}
+			if (changes.empty()) {
+				return;
+			}
+
+			for (const auto& [id, callback] : _callbacks) {
+				callbacks.push_back(callback);
+			}
+			eventHandles = _eventHandles;
+		}
+
+		// dispatched without holding the lock, so callbacks can register or unregister actors
+		for (const auto& change : changes) {
+			for (const auto& callback : callbacks) {
+				callback(change);
+			}
+			for (const auto handle : eventHandles) {
+				if (change.target != change.previousTarget) {
+					SendCustomEvent(handle, std::string(kTargetChangedEvent), RE::MakeFunctionArguments(change.actor, change.target));
+				}
+				if (change.state != change.previousState) {
+					SendCustomEvent(handle, std::string(kStateChangedEvent), RE::MakeFunctionArguments(change.actor, static_cast<std::int32_t>(change.state)));
+				}
+			}
+		}
+	}
+
+/******************************************************************************************/
+
+	RE::Actor* GetCombatTarget(RE::Actor* a_actor) {
+		if (!a_actor) {
+			return nullptr;
+		}
+
+		auto targetHandle = a_actor->GetActorRuntimeData().currentCombatTarget;
         RE::Actor* target = nullptr;
         if (targetHandle) {
 			auto targetPtr = targetHandle.get();
@@ -681,6 +1554,106 @@ namespace _ts_SKSEFunctions {
 */		
 	}
 
+/******************************************************************************************/
+
+	CombatRetargetQueue* CombatRetargetQueue::GetSingleton() {
+		static CombatRetargetQueue singleton;
+		return &singleton;
+	}
+
+	void CombatRetargetQueue::Enqueue(RE::Actor* a_actor, RE::Actor* a_target) {
+		if (!a_actor || !a_target) {
+			spdlog::error("_ts_SKSEFunctions - {}: a_actor or a_target is None", __func__);
+			return;
+		}
+
+		std::lock_guard lock(_lock);
+		_pending.push_back({ a_actor->GetHandle(), a_target->GetHandle() });
+		++_stats.requests;
+		if (!_flushScheduled) {
+			_flushScheduled = true;
+			SKSE::GetTaskInterface()->AddTask([]() { CombatRetargetQueue::GetSingleton()->Flush(); });
+		}
+	}
+
+	void CombatRetargetQueue::Flush() {
+		std::vector<Request> requests;
+		{
+			std::lock_guard lock(_lock);
+			requests.swap(_pending);
+			_flushScheduled = false;
+		}
+		if (requests.empty()) {
+			return;
+		}
+
+		// the last request per actor wins
+		std::unordered_map<RE::Actor*, RE::Actor*> targets;
+		std::vector<RE::Actor*> actors;
+		for (const auto& request : requests) {
+			auto actor = request.actor.get();
+			auto target = request.target.get();
+			if (!actor || !target) {
+				continue;
+			}
+			if (targets.insert_or_assign(actor.get(), target.get()).second) {
+				actors.push_back(actor.get());
+			}
+		}
+
+		// one consolidated target list per combat group, in request order
+		std::unordered_map<RE::CombatGroup*, std::vector<RE::Actor*>> groupTargets;
+		std::size_t retargeted = 0;
+		for (auto* actor : actors) {
+			auto* combatGroup = actor->GetCombatGroup();
+			if (!combatGroup) {
+				spdlog::info("_ts_SKSEFunctions - {}: Actor {} is not in combat...", __func__, actor->GetFormID());
+				continue;
+			}
+			auto& groupList = groupTargets[combatGroup];
+			if (std::find(groupList.begin(), groupList.end(), targets[actor]) == groupList.end()) {
+				groupList.push_back(targets[actor]);
+			}
+			++retargeted;
+		}
+
+		for (auto& [combatGroup, groupList] : groupTargets) {
+			combatGroup->targets.clear();
+			for (auto* target : groupList) {
+				RE::CombatTarget newTarget;
+				newTarget.targetHandle = target->GetHandle();
+				combatGroup->targets.push_back(newTarget);
+			}
+		}
+
+		for (auto* actor : actors) {
+			auto* combatGroup = actor->GetCombatGroup();
+			if (!combatGroup || !groupTargets.contains(combatGroup)) {
+				continue;
+			}
+			actor->SetCombatGroup(combatGroup);
+			actor->GetActorRuntimeData().currentCombatTarget = targets[actor]->GetHandle();
+			actor->UpdateCombat();
+		}
+
+		std::lock_guard lock(_lock);
+		++_stats.flushes;
+		_stats.groupRebuilds += groupTargets.size();
+		_stats.rebuildsAvoided += retargeted - groupTargets.size();
+		_stats.combatUpdates += retargeted;
+		_stats.supersededRequests += requests.size() - actors.size();
+	}
+
+	CombatRetargetQueue::Stats CombatRetargetQueue::GetStats() const {
+		std::lock_guard lock(_lock);
+		return _stats;
+	}
+
+	void CombatRetargetQueue::ResetStats() {
+		std::lock_guard lock(_lock);
+		_stats = Stats();
+	}
+
 /******************************************************************************************/
 
     float GetAngleBetweenVectors(const RE::NiPoint3& a, const RE::NiPoint3& b) {
@@ -696,6 +1669,47 @@ namespace _ts_SKSEFunctions {
         return 180.0f * std::acos(cosTheta) / 3.14159265f;
     }
 
+/******************************************************************************************/
+
+	// Batched cone test used by the camera-direction searches, the kernel itself is in ConeFilterKernel.cpp
+
+	static bool PrepareConeFilter(std::size_t a_count, std::span<std::uint64_t> a_outMask, const RE::NiPoint3& a_apex,
+								  const RE::NiPoint3& a_axis, float a_angleTolerance, ConeParams& a_params) {
+		const std::size_t wordCount = (a_count + 63) / 64;
+		if (a_outMask.size() < wordCount) {
+			spdlog::error("_ts_SKSEFunctions - {}: mask holds {} words, {} needed", __func__, a_outMask.size(), wordCount);
+			return false;
+		}
+
+		bool allInside = false;
+		if (!GetConeParams(a_apex.x, a_apex.y, a_apex.z, a_axis.x, a_axis.y, a_axis.z, a_angleTolerance, a_params, allInside)) {
+			FillConeMask(a_count, allInside, a_outMask.data());
+			return false;
+		}
+		return true;
+	}
+
+	void ConeFilter(std::span<const float> a_x, std::span<const float> a_y, std::span<const float> a_z,
+					const RE::NiPoint3& a_apex, const RE::NiPoint3& a_axis, float a_angleTolerance, std::span<std::uint64_t> a_outMask) {
+		const std::size_t count = std::min({ a_x.size(), a_y.size(), a_z.size() });
+		ConeParams params;
+		if (!PrepareConeFilter(count, a_outMask, a_apex, a_axis, a_angleTolerance, params)) {
+			return;
+		}
+
+		ConeFilterPoints(a_x.data(), a_y.data(), a_z.data(), count, params, a_outMask.data());
+	}
+
+	void ConeFilterScalar(std::span<const float> a_x, std::span<const float> a_y, std::span<const float> a_z,
+						  const RE::NiPoint3& a_apex, const RE::NiPoint3& a_axis, float a_angleTolerance, std::span<std::uint64_t> a_outMask) {
+		const std::size_t count = std::min({ a_x.size(), a_y.size(), a_z.size() });
+		ConeParams params;
+		if (!PrepareConeFilter(count, a_outMask, a_apex, a_axis, a_angleTolerance, params)) {
+			return;
+		}
+		ConeFilterPoints(a_x.data(), a_y.data(), a_z.data(), count, params, a_outMask.data(), false);
+	}
+
 /******************************************************************************************/
 
 	float GetAngleZ(const RE::NiPoint3& a_from, const RE::NiPoint3& a_to)
@@ -703,51 +1717,306 @@ namespace _ts_SKSEFunctions {
 		const auto x = a_to.x - a_from.x;
 		const auto y = a_to.y - a_from.y;
 
-		return atan2(x, y);
+		return atan2(x, y);
+	}
+
+/******************************************************************************************/
+
+	// Cache of the resolved target point nodes per actor.
+	// NiAVObject_LookupBoneNodeByName is a recursive name search through the actor's scene graph,
+	// so the nodes are only looked up again when the actor's 3D root or race changes.
+	// Entries are dropped when the actor's 3D unloads and when a game is loaded, and the released nodes are
+	// handed to the main thread, so the scene graph is never destroyed on a Papyrus or worker thread.
+	struct TargetPointCacheEntry
+	{
+		RE::NiPointer<RE::NiAVObject> root;  // keeps the root alive, so its address can't be reused by another 3D
+		RE::TESRace* race = nullptr;
+		std::array<std::int8_t, RE::BGSBodyPartDefs::LIMB_ENUM::kTotal> limbSlots{};  // index into nodes, -1 if not found
+		std::vector<RE::NiPointer<RE::NiAVObject>> nodes;
+		std::vector<RE::NiPoint3> positions;  // world positions of nodes, sized once so spans over it stay valid
+		std::uint32_t positionsTime = 0;      // application runtime of the frame the positions were read in
+		bool hasPositions = false;
+		std::uint32_t lastUsed = 0;
+	};
+
+	static std::mutex g_targetPointCacheLock;
+	static std::unordered_map<RE::FormID, TargetPointCacheEntry> g_targetPointCache;
+	static std::uint32_t g_targetPointCacheLastSweep = 0;
+
+	// entries of actors that haven't been queried for this long are released with their nodes
+	constexpr std::uint32_t kTargetPointCacheExpiry_ms = 10000;
+
+	// the last references to the nodes are dropped in a task, which runs on the main thread
+	static void ReleaseTargetPointCacheEntries(std::vector<TargetPointCacheEntry>&& a_entries) {
+		if (a_entries.empty()) {
+			return;
+		}
+
+		auto released = std::make_shared<std::vector<TargetPointCacheEntry>>(std::move(a_entries));
+		SKSE::GetTaskInterface()->AddTask([released]() { released->clear(); });
+	}
+
+	class TargetPointCacheEventSink :
+		public RE::BSTEventSink<RE::TESObjectLoadedEvent>,
+		public RE::BSTEventSink<RE::TESLoadGameEvent>
+	{
+	public:
+		static TargetPointCacheEventSink* GetSingleton() {
+			static TargetPointCacheEventSink singleton;
+			return &singleton;
+		}
+
+		static void Register() {
+			static std::once_flag registered;
+			std::call_once(registered, []() {
+				if (auto* eventSource = RE::ScriptEventSourceHolder::GetSingleton()) {
+					eventSource->AddEventSink<RE::TESObjectLoadedEvent>(GetSingleton());
+					eventSource->AddEventSink<RE::TESLoadGameEvent>(GetSingleton());
+				}
+			});
+		}
+
+		RE::BSEventNotifyControl ProcessEvent(const RE::TESObjectLoadedEvent* a_event, RE::BSTEventSource<RE::TESObjectLoadedEvent>*) override {
+			if (a_event && !a_event->loaded) {
+				std::vector<TargetPointCacheEntry> released;
+				{
+					std::lock_guard lock(g_targetPointCacheLock);
+					if (auto node = g_targetPointCache.extract(a_event->formID)) {
+						released.push_back(std::move(node.mapped()));
+					}
+				}
+				// events are sent on the main thread, the nodes are released when released goes out of scope
+			}
+			return RE::BSEventNotifyControl::kContinue;
+		}
+
+		RE::BSEventNotifyControl ProcessEvent(const RE::TESLoadGameEvent*, RE::BSTEventSource<RE::TESLoadGameEvent>*) override {
+			ClearTargetPointCache();
+			return RE::BSEventNotifyControl::kContinue;
+		}
+	};
+
+	static void RefreshTargetPointCacheEntry(TargetPointCacheEntry& a_entry, RE::NiAVObject* a_root, RE::TESRace* a_race,
+											 std::vector<TargetPointCacheEntry>& a_released) {
+		// the previous nodes are released by the caller, outside of the lock
+		if (a_entry.root || !a_entry.nodes.empty()) {
+			a_released.push_back(std::move(a_entry));
+			a_entry = TargetPointCacheEntry();
+		}
+		a_entry.root.reset(a_root);
+		a_entry.race = a_race;
+		a_entry.limbSlots.fill(-1);
+
+		RE::BGSBodyPartData* bodyPartData = a_race ? a_race->bodyPartData : nullptr;
+		if (!a_root || !bodyPartData) {
+			return;
+		}
+
+		for (std::uint32_t i = 0; i < RE::BGSBodyPartDefs::LIMB_ENUM::kTotal; ++i) {
+			RE::BGSBodyPart* bodyPart = bodyPartData->parts[i];
+			if (bodyPart && bodyPart->targetName.c_str()) {
+				auto targetPoint = RE::NiPointer<RE::NiAVObject>(NiAVObject_LookupBoneNodeByName(a_root, bodyPart->targetName, true));
+				if (targetPoint) {
+					a_entry.limbSlots[i] = static_cast<std::int8_t>(a_entry.nodes.size());
+					a_entry.nodes.push_back(std::move(targetPoint));
+				}
+			}
+		}
+		a_entry.positions.resize(a_entry.nodes.size());
+	}
+
+	// returns the up-to-date cache entry of a_actor, must be called with g_targetPointCacheLock held.
+	// Entries (or nodes) that are replaced or expired are moved to a_released, to be passed to
+	// ReleaseTargetPointCacheEntries() once the lock is released
+	static TargetPointCacheEntry* GetTargetPointCacheEntry(RE::Actor* a_actor, std::vector<TargetPointCacheEntry>& a_released) {
+		if (!a_actor) {
+			return nullptr;
+		}
+
+		TargetPointCacheEventSink::Register();
+
+		const std::uint32_t now = RE::GetDurationOfApplicationRunTime();
+		if (now - g_targetPointCacheLastSweep > kTargetPointCacheExpiry_ms) {
+			for (auto it = g_targetPointCache.begin(); it != g_targetPointCache.end();) {
+				if (now - it->second.lastUsed > kTargetPointCacheExpiry_ms) {
+					a_released.push_back(std::move(it->second));
+					it = g_targetPointCache.erase(it);
+				} else {
+					++it;
+				}
+			}
+			g_targetPointCacheLastSweep = now;
+		}
+
+		auto* root = a_actor->Get3D2();
+		auto* race = a_actor->GetRace();
+
+		auto& entry = g_targetPointCache[a_actor->GetFormID()];
+		if (entry.root.get() != root || entry.race != race || entry.lastUsed == 0) {
+			RefreshTargetPointCacheEntry(entry, root, race, a_released);
+		}
+		entry.lastUsed = now != 0 ? now : 1;
+		return &entry;
+	}
+
+	std::span<const RE::NiPoint3> GetCachedTargetPointPositions(RE::Actor* a_actor) {
+		std::vector<TargetPointCacheEntry> released;
+		std::span<const RE::NiPoint3> positions;
+		{
+			std::lock_guard lock(g_targetPointCacheLock);
+			if (auto* entry = GetTargetPointCacheEntry(a_actor, released)) {
+				// the application runtime only advances once per frame, so this reads the nodes once per frame
+				const std::uint32_t now = RE::GetDurationOfApplicationRunTime();
+				if (!entry->hasPositions || entry->positionsTime != now) {
+					// same size as nodes since the last refresh, so the storage (and spans over it) stays in place
+					for (std::size_t i = 0; i < entry->nodes.size(); ++i) {
+						entry->positions[i] = entry->nodes[i]->world.translate;
+					}
+					entry->positionsTime = now;
+					entry->hasPositions = true;
+				}
+				positions = entry->positions;
+			}
+		}
+		ReleaseTargetPointCacheEntries(std::move(released));
+		return positions;
+	}
+
+	void ClearTargetPointCache() {
+		std::vector<TargetPointCacheEntry> released;
+		{
+			std::lock_guard lock(g_targetPointCacheLock);
+			released.reserve(g_targetPointCache.size());
+			for (auto& [formID, entry] : g_targetPointCache) {
+				released.push_back(std::move(entry));
+			}
+			g_targetPointCache.clear();
+		}
+		ReleaseTargetPointCacheEntries(std::move(released));
 	}
 
 /******************************************************************************************/
 
     RE::NiPointer<RE::NiAVObject> GetTargetPoint(RE::Actor* a_actor, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart) {
-        RE::NiPointer<RE::NiAVObject> targetPoint = nullptr;
-
-        if (!a_actor) {
-            return nullptr;
-        }
-
-        auto race = a_actor->GetRace();
-        if (!race) {
-            return nullptr;
-        }
-
-        RE::BGSBodyPartData* bodyPartData = race->bodyPartData;
-        if (!bodyPartData) {
+        if (!a_actor || a_bodyPart >= RE::BGSBodyPartDefs::LIMB_ENUM::kTotal) {
             return nullptr;
         }
 
-        auto actor3D = a_actor->Get3D2();
-        if (!actor3D) {
-            return nullptr;
-        }
-    
-        RE::BGSBodyPart* bodyPart = bodyPartData->parts[a_bodyPart];
-
-		if (bodyPart) {
-            targetPoint = RE::NiPointer<RE::NiAVObject>(NiAVObject_LookupBoneNodeByName(actor3D, bodyPart->targetName, true));
+        std::vector<TargetPointCacheEntry> released;
+        RE::NiPointer<RE::NiAVObject> targetPoint;
+        {
+            std::lock_guard lock(g_targetPointCacheLock);
+            const auto* entry = GetTargetPointCacheEntry(a_actor, released);
+            if (entry && entry->limbSlots[a_bodyPart] >= 0) {
+                targetPoint = entry->nodes[entry->limbSlots[a_bodyPart]];
+            }
         }
+        ReleaseTargetPointCacheEntries(std::move(released));
 
         return targetPoint;
     }	
 
  /******************************************************************************************/
 
+	static_assert(kBodyPartLimbNames.size() == RE::BGSBodyPartDefs::LIMB_ENUM::kTotal);
+	// BodyPartAxisMapping::Apply() reads the rotation as 9 floats
+	static_assert(sizeof(RE::NiMatrix3) == 9 * sizeof(float));
+
+	BodyPartFrameTable* BodyPartFrameTable::GetSingleton() {
+		static BodyPartFrameTable singleton;
+		static std::once_flag loaded;
+		std::call_once(loaded, [] {
+			singleton.LoadDefaults();
+			const auto configPath = std::filesystem::current_path() / "Data" / kConfigFile;
+			if (std::filesystem::is_regular_file(configPath)) {
+				singleton.LoadFromFile(configPath);
+			}
+		});
+		return &singleton;
+	}
+
+	void BodyPartFrameTable::LoadDefaults() {
+		{
+			std::lock_guard lock(_lock);
+			_mappings.Clear();
+			_byForm.clear();
+		}
+		LoadFromString(kDefaultBodyPartFrames);
+	}
+
+	bool BodyPartFrameTable::LoadFromFile(const std::filesystem::path& a_path) {
+		std::ifstream file(a_path, std::ios::binary);
+		if (!file) {
+			spdlog::error("_ts_SKSEFunctions - {}: Failed to open {}", __func__, a_path.string());
+			return false;
+		}
+		const std::string data{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+		return Load(data, a_path.string());
+	}
+
+	bool BodyPartFrameTable::LoadFromString(std::string_view a_data) {
+		return Load(a_data, "body part frame mappings");
+	}
+
+	bool BodyPartFrameTable::Load(std::string_view a_data, std::string_view a_source) {
+		std::vector<std::string> warnings;
+		std::size_t count;
+		{
+			std::lock_guard lock(_lock);
+			count = _mappings.Parse(a_data, &warnings);
+			// body part data resolved so far may be affected
+			_byForm.clear();
+		}
+
+		for (const auto& warning : warnings) {
+			spdlog::warn("_ts_SKSEFunctions - {}: {}, {}", __func__, a_source, warning);
+		}
+		spdlog::info("_ts_SKSEFunctions - {}: Loaded {} body part frame mappings from {}", __func__, count, a_source);
+		return warnings.empty();
+	}
+
+	void BodyPartFrameTable::Set(RE::BGSBodyPartDefs::LIMB_ENUM a_limb, std::string_view a_editorID, const BodyPartAxisMapping& a_mapping) {
+		std::lock_guard lock(_lock);
+		_mappings.Set(a_limb, a_editorID, a_mapping);
+		// body part data resolved so far may be affected
+		_byForm.clear();
+	}
+
+	std::optional<BodyPartAxisMapping> BodyPartFrameTable::Find(std::string_view a_editorID, RE::BGSBodyPartDefs::LIMB_ENUM a_limb) const {
+		if (a_limb >= RE::BGSBodyPartDefs::LIMB_ENUM::kTotal) {
+			return std::nullopt;
+		}
+		std::lock_guard lock(_lock);
+		const auto* mappings = _mappings.Find(a_editorID);
+		return mappings ? (*mappings)[a_limb] : std::nullopt;
+	}
+
+	std::optional<BodyPartAxisMapping> BodyPartFrameTable::Find(const RE::BGSBodyPartData* a_bodyPartData, RE::BGSBodyPartDefs::LIMB_ENUM a_limb) {
+		if (!a_bodyPartData || a_limb >= RE::BGSBodyPartDefs::LIMB_ENUM::kTotal) {
+			return std::nullopt;
+		}
+
+		std::lock_guard lock(_lock);
+		auto it = _byForm.find(a_bodyPartData->GetFormID());
+		if (it == _byForm.end()) {
+			// first query for this body part data: resolve its editor ID once
+			const auto editorID = clib_util::editorID::get_editorID(a_bodyPartData);
+			const auto* mappings = _mappings.Find(editorID);
+			it = _byForm.emplace(a_bodyPartData->GetFormID(), mappings ? *mappings : BodyPartLimbMappings{}).first;
+
+			for (std::uint32_t limb = 0; limb < RE::BGSBodyPartDefs::LIMB_ENUM::kTotal; ++limb) {
+				if (!it->second[limb] && (limb == RE::BGSBodyPartDefs::LIMB_ENUM::kHead || limb == RE::BGSBodyPartDefs::LIMB_ENUM::kTorso)) {
+					log::warn("{}: Unhandled {} body part EDID '{}', using default coordinate frame", __FUNCTION__, kBodyPartLimbNames[limb], editorID);
+				}
+			}
+		}
+		return it->second[a_limb];
+	}
+
+/******************************************************************************************/
+
 	 void GetBodyPartCoordinateFrame(RE::Actor* a_actor, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart,
                                      RE::NiPoint3& a_forward, RE::NiPoint3& a_right, RE::NiPoint3& a_up) {
-        // Different races use different rotation matrix columns for their forward direction
-        // This mapping is based on how each body part data defines its local coordinate system
-		// Note: The coordinate frame mapping can be different for different body parts of the same race
-        //       So far this function only supports the mapping for kHead and kTorso
-
 		a_forward = RE::NiPoint3(0.0f, 1.0f, 0.0f);  // Default forward
 		a_right = RE::NiPoint3(1.0f, 0.0f, 0.0f);    // Default right
 		a_up = RE::NiPoint3(0.0f, 0.0f, 1.0f);       // Default up
@@ -763,187 +2032,66 @@ namespace _ts_SKSEFunctions {
             return;
 		}
 
-        const RE::NiMatrix3& rotMatrix = targetPoint->world.rotate;
-        RE::NiPoint3 rotationX = rotMatrix.GetVectorX();
-        RE::NiPoint3 rotationY = rotMatrix.GetVectorY();
-        RE::NiPoint3 rotationZ = rotMatrix.GetVectorZ();
-
         // Default: right=+X, forward=+Y, up=+Z (standard humanoid)
-        a_forward = rotationY;
-        a_right = rotationX;
-        a_up = rotationZ;
+        BodyPartAxisMapping mapping;
 
         auto race = a_actor->GetRace();
-        if (!race || !race->bodyPartData) {
-            return;
-        }
-        
-        auto bodyPartData = race->bodyPartData;
-        auto bodyPartEDID = clib_util::editorID::get_editorID(bodyPartData);
-        
-        if (a_bodyPart == RE::BGSBodyPartDefs::LIMB_ENUM::kHead) {
-            // +X: Right / +Y: Forward / +Z: Up
-            if (bodyPartEDID == "AtronachFlameBodyPartData" ||
-                bodyPartEDID == "AtronachFrostBodyPartData" ||
-                bodyPartEDID == "AtronachStormBodyPartData" ||
-                bodyPartEDID == "BenthicLurkerBodyPartData" ||
-                bodyPartEDID == "DefaultBodyPartData" ||
-                bodyPartEDID == "DLC2NetchBodyPartData" ||
-                bodyPartEDID == "DLC2RieklingBodyPartData" ||
-                bodyPartEDID == "DragonPriestBodyPartData" ||
-                bodyPartEDID == "DraugrBodyPartData" ||
-                bodyPartEDID == "DwarvenBallistaCenturionBodyPartData" ||
-                bodyPartEDID == "DwarvenSpiderPartData" ||
-                bodyPartEDID == "FalmerBodyPartData" ||
-                bodyPartEDID == "GargoyleBodyPartData" ||
-                bodyPartEDID == "GiantBodyPartData" ||
-                bodyPartEDID == "HagravenBodyPartData" ||
-                bodyPartEDID == "MudcrabPartData" ||
-                bodyPartEDID == "SprigganBodyPartData" ||
-                bodyPartEDID == "TrollBodyPartData" ||
-                bodyPartEDID == "WerewolfBeastBodyPartData" ||
-                bodyPartEDID == "WispBodyPartData") {
-                a_forward = rotationY;
-                a_right = rotationX;
-                a_up = rotationZ;
-            }
-            // +X: Up / +Y: Forward / +Z: Left
-            else if (bodyPartEDID == "DLC2HMDaedraPartData" ||
-                     bodyPartEDID == "DLC2MountedRieklingBodyPartData" ||
-                     bodyPartEDID == "DLC2ScribBodyPartData" ||
-                     bodyPartEDID == "DwarvenSphereCenturionBodyPartData" ||
-                     bodyPartEDID == "FrostbiteSpiderPartData" ||
-                     bodyPartEDID == "SlaughterfishBodyPartData" ||
-                     bodyPartEDID == "WitchlightBodyPartData") {
-                a_forward = rotationY;
-                a_right = rotationZ;
-                a_up = rotationX;
-            }
-            // +X: Forward / +Y: Down / +Z: Left
-            else if (bodyPartEDID == "BearBodyPartData" ||
-                     bodyPartEDID == "ChaurusBodyPartData" ||
-                     bodyPartEDID == "CowBodyPartData" ||
-                     bodyPartEDID == "DLC2DragonBodyPartData" ||
-                     bodyPartEDID == "DragonBodyPartData" ||
-                     bodyPartEDID == "MammothBodyPartData" ||
-                     bodyPartEDID == "SabreCatBodyPartData") {
-                a_forward = rotationX;
-                a_right = -rotationZ;
-                a_up = -rotationY;
+        if (race && race->bodyPartData) {
+            if (const auto raceMapping = BodyPartFrameTable::GetSingleton()->Find(race->bodyPartData, a_bodyPart)) {
+                mapping = *raceMapping;
+            } else if (a_bodyPart != RE::BGSBodyPartDefs::LIMB_ENUM::kHead && a_bodyPart != RE::BGSBodyPartDefs::LIMB_ENUM::kTorso) {
+                // head and torso are warned about once per body part data, see BodyPartFrameTable::Find()
+                log::warn("{}: Unsupported body part enum '{}', using default coordinate frame", __FUNCTION__, a_bodyPart);
             }
-            // +X: Right / +Y: Down / +Z: Forward
-            else if (bodyPartEDID == "ChaurusFlyerBodyPartData" ||
-                     bodyPartEDID == "ChickenBodyPartData" ||
-                     bodyPartEDID == "DeerBodyPartData" ||
-                     bodyPartEDID == "DogBodyPartData" ||
-                     bodyPartEDID == "DwarvenSteamCenturionBodyPartData" ||
-                     bodyPartEDID == "GoatBodyPartData" ||
-                     bodyPartEDID == "HareBodyPartData" ||
-                     bodyPartEDID == "HorseBodyPartData" ||
-                     bodyPartEDID == "SkeeverBodyPartData") {
-                a_forward = rotationZ;
-                a_right = rotationX;
-                a_up = -rotationY;
-            }
-            // +X: Backward / +Y: Right / +Z: Up
-            else if (bodyPartEDID == "IceWraithBodyPartData") {
-                a_forward = -rotationX;
-                a_right = rotationY;
-                a_up = rotationZ;
-            }
-            // +X: Right / +Y: Backwards / +Z: Down
-            else if (bodyPartEDID == "HorkerBodyPartData") {
-                a_forward = -rotationY;
-                a_right = rotationX;
-                a_up = -rotationZ;
-            }
-            else {
-                log::warn("{}: Unhandled head body part EDID '{}', using default coordinate frame", __FUNCTION__, bodyPartEDID);
-            }
-        } else if (a_bodyPart == RE::BGSBodyPartDefs::LIMB_ENUM::kTorso) {
-            // +X: Right / +Y: Forward / +Z: Up
-            if (bodyPartEDID == "AtronachFlameBodyPartData" ||
-                bodyPartEDID == "AtronachFrostBodyPartData" ||
-                bodyPartEDID == "AtronachStormBodyPartData" ||
-                bodyPartEDID == "BenthicLurkerBodyPartData" ||
-                bodyPartEDID == "DefaultBodyPartData" ||
-                bodyPartEDID == "DLC2NetchBodyPartData" ||
-                bodyPartEDID == "DLC2RieklingBodyPartData" ||
-                bodyPartEDID == "DragonPriestBodyPartData" ||
-                bodyPartEDID == "DraugrBodyPartData" ||
-                bodyPartEDID == "DwarvenBallistaCenturionBodyPartData" ||
-                bodyPartEDID == "DwarvenSpiderPartData" ||
-                bodyPartEDID == "DwarvenSteamCenturionBodyPartData" ||
-                bodyPartEDID == "FalmerBodyPartData" ||
-                bodyPartEDID == "GargoyleBodyPartData" ||
-                bodyPartEDID == "GiantBodyPartData" ||
-                bodyPartEDID == "HagravenBodyPartData" ||
-                bodyPartEDID == "MudcrabPartData" ||
-                bodyPartEDID == "SprigganBodyPartData" ||
-                bodyPartEDID == "TrollBodyPartData" ||
-                bodyPartEDID == "WerewolfBeastBodyPartData" ||
-                bodyPartEDID == "WitchlightBodyPartData") {
-                a_forward = rotationY;
-                a_right = rotationX;
-                a_up = rotationZ;
-            }
-            // +X: Up / +Y: Forward / +Z: Left
-            else if (bodyPartEDID == "DLC2DragonBodyPartData" ||
-                     bodyPartEDID == "DLC2HMDaedraPartData" ||
-                     bodyPartEDID == "DLC2MountedRieklingBodyPartData" ||
-                     bodyPartEDID == "DragonBodyPartData" ||
-                     bodyPartEDID == "SlaughterfishBodyPartData" ||
-                     bodyPartEDID == "WispBodyPartData") {
-                a_forward = rotationY;
-                a_right = rotationZ;
-                a_up = rotationX;
-            }
-            // +X: Forward / +Y: Down / +Z: Left
-            else if (bodyPartEDID == "BearBodyPartData" ||
-                     bodyPartEDID == "ChaurusBodyPartData" ||
-                     bodyPartEDID == "CowBodyPartData" ||
-                     bodyPartEDID == "DLC2ScribBodyPartData" ||
-                     bodyPartEDID == "DwarvenSphereCenturionBodyPartData" ||
-                     bodyPartEDID == "MammothBodyPartData" ||
-                     bodyPartEDID == "SabreCatBodyPartData") {
-                a_forward = rotationX;
-                a_right = -rotationZ;
-                a_up = -rotationY;
-            }
-            // +X: Right / +Y: Down / +Z: Forward
-            else if (bodyPartEDID == "ChaurusFlyerBodyPartData" ||
-                     bodyPartEDID == "ChickenBodyPartData" ||
-                     bodyPartEDID == "DeerBodyPartData" ||
-                     bodyPartEDID == "DogBodyPartData" ||
-                     bodyPartEDID == "HareBodyPartData" ||
-                     bodyPartEDID == "HorkerBodyPartData" ||
-                     bodyPartEDID == "HorseBodyPartData" ||
-                     bodyPartEDID == "GoatBodyPartData" ||
-                     bodyPartEDID == "SkeeverBodyPartData") {
-                a_forward = rotationZ;
-                a_right = rotationX;
-                a_up = -rotationY;
-            }
-            // +X: Backward / +Y: Right / +Z: Up
-            else if (bodyPartEDID == "IceWraithBodyPartData") {
-                a_forward = -rotationX;
-                a_right = rotationY;
-                a_up = rotationZ;
-            }
-            // +X: Backward / +Y: Up / +Z: Left
-            else if (bodyPartEDID == "FrostbiteSpiderPartData") {
-                a_forward = -rotationX;
-                a_right = rotationZ;
-                a_up = rotationY;
-            }
-            else {
-                log::warn("{}: Unhandled torso body part EDID '{}', using default coordinate frame", __FUNCTION__, bodyPartEDID);
-            }
-        } else {
-			log::warn("{}: Unsupported body part enum '{}', using default coordinate frame", __FUNCTION__, a_bodyPart);
-		}
+        }
+
+        mapping.Apply(&targetPoint->world.rotate.entry[0][0], &a_forward.x, &a_right.x, &a_up.x);
     }
 
+/******************************************************************************************/
+
+	// the rotation kernel reads the frames as arrays of 3 floats
+	static_assert(sizeof(RE::NiPoint3) == 3 * sizeof(float));
+
+	// computes pitch/roll/yaw like GetBodyPartRotation() from the forward and up vectors of a body part
+	static RE::NiPoint3 GetRotationFromFrame(const RE::NiPoint3& forward, const RE::NiPoint3& up) {
+		RE::NiPoint3 rotation;
+		RotationFromFrame(&forward.x, &up.x, rotation.x, rotation.y, rotation.z);
+		return rotation;
+	}
+
+/******************************************************************************************/
+
+	void GetRotationsFromFrames(std::span<const RE::NiPoint3> a_forward, std::span<const RE::NiPoint3> a_up,
+								std::span<float> a_pitch, std::span<float> a_roll, std::span<float> a_yaw, bool a_precise) {
+		const std::size_t count = std::min({ a_forward.size(), a_up.size(), a_pitch.size(), a_roll.size(), a_yaw.size() });
+		RotationsFromFrames(reinterpret_cast<const float*>(a_forward.data()), reinterpret_cast<const float*>(a_up.data()), count,
+			a_pitch.data(), a_roll.data(), a_yaw.data(), a_precise);
+	}
+
+	void GetBodyPartRotations(std::span<RE::Actor* const> a_actors, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart,
+							  std::span<float> a_pitch, std::span<float> a_roll, std::span<float> a_yaw, bool a_precise) {
+		const std::size_t count = std::min({ a_actors.size(), a_pitch.size(), a_roll.size(), a_yaw.size() });
+
+		thread_local std::vector<RE::NiPoint3> forward;
+		thread_local std::vector<RE::NiPoint3> up;
+		forward.resize(count);
+		up.resize(count);
+
+		RE::NiPoint3 right;
+		for (std::size_t i = 0; i < count; ++i) {
+			if (a_actors[i]) {
+				GetBodyPartCoordinateFrame(a_actors[i], a_bodyPart, forward[i], right, up[i]);
+			} else {
+				// same result as GetBodyPartRotation() for a missing actor
+				forward[i] = RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
+				up[i] = RE::NiPoint3{ 0.0f, 0.0f, 1.0f };
+			}
+		}
+
+		GetRotationsFromFrames(forward, up, a_pitch.first(count), a_roll.first(count), a_yaw.first(count), a_precise);
+	}
+
 /******************************************************************************************/
 
     RE::NiPoint3 GetBodyPartRotation(RE::Actor* a_actor, RE::BGSBodyPartDefs::LIMB_ENUM a_bodyPart) {
@@ -956,37 +2104,7 @@ namespace _ts_SKSEFunctions {
         RE::NiPoint3 forward, right, up;
         GetBodyPartCoordinateFrame(a_actor, a_bodyPart, forward, right, up);
 
-        float yaw = std::atan2(forward.x, forward.y);        
-        float pitch = std::asin(std::clamp(-forward.z, -1.0f, 1.0f));
-        
-        // Compute roll from the up vector's deviation from world up
-        // Project the up vector onto the plane perpendicular to forward
-        // Then measure its rotation relative to the expected "up" direction
-        float cosPitch = std::cos(pitch);
-        float sinPitch = std::sin(pitch);
-        float cosYaw = std::cos(yaw);
-        float sinYaw = std::sin(yaw);
-        
-        // Expected up vector (world +Z rotated by pitch and yaw only, zero roll)
-        RE::NiPoint3 expectedUp(
-            -sinPitch * sinYaw,
-            -sinPitch * cosYaw,
-            cosPitch
-        );
-        
-        // Expected right vector (perpendicular to both forward and expectedUp)
-        RE::NiPoint3 expectedRight(
-            cosYaw,
-            -sinYaw,
-            0.0f
-        );
-        
-        // Project actual up vector onto the expectedUp and expectedRight to get roll angle
-        float upDotExpectedUp = up.Dot(expectedUp);
-        float upDotExpectedRight = up.Dot(expectedRight);
-        float roll = -std::atan2(upDotExpectedRight, upDotExpectedUp);
-        
-        return RE::NiPoint3{pitch, roll, yaw};
+        return GetRotationFromFrame(forward, up);
     }	
 
 /******************************************************************************************/
@@ -1222,44 +2340,452 @@ namespace _ts_SKSEFunctions {
     }
 
 /******************************************************************************************/
-    std::vector<RE::NiPointer<RE::NiAVObject>> GetAllTargetPoints(RE::Actor* a_actor) {
-        std::vector<RE::NiPointer<RE::NiAVObject>> targetPoints;
-
-        if (!a_actor) {
-            return targetPoints;
+    std::span<const RE::NiPointer<RE::NiAVObject>> GetAllTargetPoints(RE::Actor* a_actor) {
+        std::vector<TargetPointCacheEntry> released;
+        std::span<const RE::NiPointer<RE::NiAVObject>> targetPoints;
+        {
+            std::lock_guard lock(g_targetPointCacheLock);
+            if (const auto* entry = GetTargetPointCacheEntry(a_actor, released)) {
+                targetPoints = entry->nodes;
+            }
         }
+        ReleaseTargetPointCacheEntries(std::move(released));
 
-        auto race = a_actor->GetRace();
-        if (!race) {
-            return targetPoints;
-        }
+        return targetPoints;
+    }
 
-        RE::BGSBodyPartData* bodyPartData = race->bodyPartData;
-        if (!bodyPartData) {
-            return targetPoints;
-        }
+/******************************************************************************************/
 
-        auto actor3D = a_actor->Get3D2();
-        if (!actor3D) {
-            return targetPoints;
-        }
+	void ActorSnapshot::Clear() {
+		handles.clear();
+		actors.clear();
+		formIDs.clear();
+		posX.clear();
+		posY.clear();
+		posZ.clear();
+		boundX.clear();
+		boundY.clear();
+		boundZ.clear();
+		boundRadius.clear();
+		flags.clear();
+		spatialIndex.Clear();
+		playerPos = RE::NiPoint3{};
+		timeStamp = 0;
+	}
 
-        // Iterate through all body parts
-        for (std::uint32_t i = 0; i < RE::BGSBodyPartDefs::LIMB_ENUM::kTotal; ++i) {
-            RE::BGSBodyPart* bodyPart = bodyPartData->parts[i];
-            if (bodyPart && bodyPart->targetName.c_str()) {
-                auto targetPoint = RE::NiPointer<RE::NiAVObject>(NiAVObject_LookupBoneNodeByName(actor3D, bodyPart->targetName, true));
-                if (targetPoint) {
-                    targetPoints.push_back(targetPoint);
-                }
-            }
-        }
+	void ActorSnapshot::Reserve(std::size_t a_capacity) {
+		handles.reserve(a_capacity);
+		actors.reserve(a_capacity);
+		formIDs.reserve(a_capacity);
+		posX.reserve(a_capacity);
+		posY.reserve(a_capacity);
+		posZ.reserve(a_capacity);
+		boundX.reserve(a_capacity);
+		boundY.reserve(a_capacity);
+		boundZ.reserve(a_capacity);
+		boundRadius.reserve(a_capacity);
+		flags.reserve(a_capacity);
+	}
 
-        return targetPoints;
-    }
+/******************************************************************************************/
+
+	ActorFilter& ActorFilter::SetFlags(std::uint8_t a_flags) {
+		_flags = a_flags;
+		_requiredFlags = (a_flags & kRequire3D) ? ActorSnapshot::k3DLoaded : ActorSnapshot::kNone;
+		_rejectedFlags = ActorSnapshot::kNone;
+		if (a_flags & kExcludeDead) {
+			_rejectedFlags |= ActorSnapshot::kDead;
+		}
+		if (a_flags & kExcludeAllies) {
+			_rejectedFlags |= ActorSnapshot::kAlly;
+		}
+		return *this;
+	}
+
+	ActorFilter& ActorFilter::SetMaxDistance(float a_maxDistance) {
+		_maxDistance = a_maxDistance;
+		return *this;
+	}
+
+	std::size_t ActorFilter::GetSlot(RE::FormID a_formID) const {
+		// multiplicative hashing, FormIDs of the same plugin only differ in the low bits
+		const std::uint32_t hash = a_formID * 0x9E3779B1u;
+		return static_cast<std::size_t>(hash ^ (hash >> 16)) & (_excluded.size() - 1);
+	}
+
+	void ActorFilter::Rehash(std::size_t a_capacity) {
+		std::vector<RE::FormID> old;
+		old.swap(_excluded);
+		_excluded.assign(a_capacity, 0);
+		_excludedCount = 0;
+		for (const auto formID : old) {
+			if (formID != 0) {
+				Exclude(formID);
+			}
+		}
+	}
+
+	void ActorFilter::Reserve(std::size_t a_count) {
+		// keep the load factor at or below 0.5
+		std::size_t capacity = 16;
+		while (capacity < a_count * 2) {
+			capacity *= 2;
+		}
+		if (capacity > _excluded.size()) {
+			Rehash(capacity);
+		}
+	}
+
+	ActorFilter& ActorFilter::Exclude(RE::FormID a_formID) {
+		if (a_formID == 0) {
+			return *this;
+		}
+		if ((_excludedCount + 1) * 2 > _excluded.size()) {
+			Reserve(_excludedCount + 1);
+		}
+
+		const std::size_t mask = _excluded.size() - 1;
+		for (std::size_t slot = GetSlot(a_formID);; slot = (slot + 1) & mask) {
+			if (_excluded[slot] == a_formID) {
+				return *this;
+			}
+			if (_excluded[slot] == 0) {
+				_excluded[slot] = a_formID;
+				++_excludedCount;
+				return *this;
+			}
+		}
+	}
+
+	ActorFilter& ActorFilter::Exclude(const RE::Actor* a_actor) {
+		if (a_actor) {
+			Exclude(a_actor->GetFormID());
+		}
+		return *this;
+	}
+
+	ActorFilter& ActorFilter::Exclude(std::span<RE::Actor* const> a_actors) {
+		Reserve(_excludedCount + a_actors.size());
+		for (const auto* actor : a_actors) {
+			Exclude(actor);
+		}
+		return *this;
+	}
+
+	void ActorFilter::ClearExcluded() {
+		if (_excludedCount > 0) {
+			std::fill(_excluded.begin(), _excluded.end(), 0);
+			_excludedCount = 0;
+		}
+	}
+
+	bool ActorFilter::IsExcluded(RE::FormID a_formID) const {
+		if (_excludedCount == 0) {
+			return false;
+		}
+
+		const std::size_t mask = _excluded.size() - 1;
+		for (std::size_t slot = GetSlot(a_formID);; slot = (slot + 1) & mask) {
+			if (_excluded[slot] == a_formID) {
+				return true;
+			}
+			if (_excluded[slot] == 0) {
+				return false;
+			}
+		}
+	}
 
 /******************************************************************************************/
-    
+
+	static std::mutex g_actorSnapshotLock;
+	static std::shared_ptr<const ActorSnapshot> g_actorSnapshot;
+	static bool g_actorSnapshotInvalidated = true;
+
+	// returns the ActorSnapshot::Flag bits of a_actor
+	static std::uint8_t GetActorSnapshotFlags(RE::Actor* a_actor, RE::Actor* a_playerActor) {
+		std::uint8_t flags = ActorSnapshot::kNone;
+		if (a_actor->Get3D()) {
+			flags |= ActorSnapshot::k3DLoaded;
+		}
+		if (a_actor->IsDead()) {
+			flags |= ActorSnapshot::kDead;
+		}
+		if (a_actor->GetFactionReaction(a_playerActor) == RE::FIGHT_REACTION::kAlly) {
+			flags |= ActorSnapshot::kAlly;
+		}
+		return flags;
+	}
+
+	static void BuildActorSnapshot(ActorSnapshot& a_snapshot) {
+		auto* playerActor = RE::PlayerCharacter::GetSingleton();
+		auto* processLists = RE::ProcessLists::GetSingleton();
+		if (!playerActor || !processLists) {
+			return;
+		}
+
+		a_snapshot.playerPos = playerActor->GetPosition();
+		a_snapshot.Reserve(processLists->highActorHandles.size());
+
+		for (auto& handle : processLists->highActorHandles) {
+			auto actorPtr = handle.get();
+			auto* actor = actorPtr.get();
+			if (!actor) {
+				continue;
+			}
+
+			const std::uint8_t flags = GetActorSnapshotFlags(actor, playerActor);
+			RE::NiPoint3 boundCenter;
+			float boundRadius = 0.0f;
+			if (auto* actor3D = actor->Get3D()) {
+				boundCenter = actor3D->worldBound.center;
+				boundRadius = actor3D->worldBound.radius;
+			}
+
+			const auto pos = actor->GetPosition();
+			a_snapshot.handles.push_back(handle);
+			a_snapshot.actors.push_back(actor);
+			a_snapshot.formIDs.push_back(actor->GetFormID());
+			a_snapshot.posX.push_back(pos.x);
+			a_snapshot.posY.push_back(pos.y);
+			a_snapshot.posZ.push_back(pos.z);
+			a_snapshot.boundX.push_back(boundCenter.x);
+			a_snapshot.boundY.push_back(boundCenter.y);
+			a_snapshot.boundZ.push_back(boundCenter.z);
+			a_snapshot.boundRadius.push_back(boundRadius);
+			a_snapshot.flags.push_back(flags);
+		}
+
+		a_snapshot.spatialIndex.Build(a_snapshot.posX, a_snapshot.posY);
+	}
+
+	// collects the snapshot indices of all actors that may be within a_maxDistance of a_center
+	// (all actors if a_maxDistance <= 0.0f); the exact distance test is left to the caller
+	static void GetSnapshotCandidates(const ActorSnapshot& a_snapshot, const RE::NiPoint3& a_center, float a_maxDistance,
+									  std::vector<std::uint32_t>& a_candidates) {
+		a_candidates.clear();
+		if (a_maxDistance > 0.0f) {
+			a_snapshot.spatialIndex.QueryRadius(a_center.x, a_center.y, a_maxDistance, a_candidates);
+			// keep the snapshot order, so that ties are resolved the same way as in a full scan
+			std::sort(a_candidates.begin(), a_candidates.end());
+		} else {
+			a_candidates.resize(a_snapshot.size());
+			std::iota(a_candidates.begin(), a_candidates.end(), 0u);
+		}
+	}
+
+	std::shared_ptr<const ActorSnapshot> GetActorSnapshot() {
+		const std::uint32_t timeStamp = RE::GetDurationOfApplicationRunTime();
+
+		std::lock_guard lock(g_actorSnapshotLock);
+		if (g_actorSnapshot && !g_actorSnapshotInvalidated && g_actorSnapshot->timeStamp == timeStamp) {
+			return g_actorSnapshot;
+		}
+
+		// the previous snapshot may still be in use by another thread, so always build into a new instance
+		auto snapshot = std::make_shared<ActorSnapshot>();
+		if (g_actorSnapshot) {
+			snapshot->Reserve(g_actorSnapshot->size());
+		}
+		BuildActorSnapshot(*snapshot);
+		snapshot->timeStamp = timeStamp;
+
+		g_actorSnapshot = std::move(snapshot);
+		g_actorSnapshotInvalidated = false;
+		return g_actorSnapshot;
+	}
+
+	void InvalidateActorSnapshot() {
+		std::lock_guard lock(g_actorSnapshotLock);
+		g_actorSnapshotInvalidated = true;
+	}
+
+/******************************************************************************************/
+
+	// Strategy 1 of the crosshair intersection test: returns the distance to the player of the closest target point
+	// (body part) within the scan cone, or FLT_MAX if none of them is.
+	// This works well at medium-to-long distances, also when the actor is hidden by other geometry
+	static float GetTargetPointScanDistance(RE::Actor* a_actor, const RE::NiPoint3& a_cameraPos, const RE::NiPoint3& a_cameraForward,
+											const RE::NiPoint3& a_playerPos, float a_maxScanAngle) {
+		float closestPointDistance = FLT_MAX;
+
+		for (const auto& pointPos : GetCachedTargetPointPositions(a_actor)) {
+			float fAngleForward = GetAngleBetweenVectors(pointPos - a_cameraPos, a_cameraForward);
+
+			if (fabsf(fAngleForward) <= a_maxScanAngle || a_maxScanAngle <= 0.0f) {
+				float distanceToPlayer = pointPos.GetDistance(a_playerPos);
+				if (distanceToPlayer < closestPointDistance) {
+					closestPointDistance = distanceToPlayer;
+				}
+			}
+		}
+
+		return closestPointDistance;
+	}
+
+	// Strategy 2 of the crosshair intersection test: ray-sphere intersection with the actor's bounding sphere.
+	// Returns the distance from the ray origin to the entry point, or FLT_MAX if the ray misses the sphere
+	static float GetRaySphereEntryDistance(const RE::NiPoint3& a_rayOrigin, const RE::NiPoint3& a_rayDirection,
+										   const RE::NiPoint3& a_sphereCenter, float a_sphereRadius) {
+		RE::NiPoint3 toSphere = a_sphereCenter - a_rayOrigin;
+		float projectionLength = toSphere.Dot(a_rayDirection);
+
+		// Skip if sphere is behind camera
+		if (projectionLength < 0) {
+			return FLT_MAX;
+		}
+
+		// Find closest point on ray to sphere center
+		RE::NiPoint3 closestPointOnRay = a_rayOrigin + (a_rayDirection * projectionLength);
+		float distanceToCenter = closestPointOnRay.GetDistance(a_sphereCenter);
+
+		// Check if ray intersects the bounding sphere
+		if (distanceToCenter <= a_sphereRadius) {
+			// Calculate actual intersection distance (entry point)
+			return (projectionLength - sqrtf(a_sphereRadius * a_sphereRadius - distanceToCenter * distanceToCenter));
+		}
+
+		return FLT_MAX;
+	}
+
+	// Batched ray tests used by the crosshair picking.
+	// Sphere entry distances follow GetRaySphereEntryDistance(): spheres with their center behind the ray origin are
+	// skipped, and the entry distance is negative if the origin is inside the sphere.
+
+	RayHit IntersectRaySpheres(const RE::NiPoint3& a_rayOrigin, const RE::NiPoint3& a_rayDirection,
+							   std::span<const float> a_centerX, std::span<const float> a_centerY, std::span<const float> a_centerZ,
+							   std::span<const float> a_radius) {
+		const std::size_t count = std::min({ a_centerX.size(), a_centerY.size(), a_centerZ.size(), a_radius.size() });
+		RayHit hit;
+
+		std::size_t i = 0;
+		if (count >= 4) {
+			const __m128 originX = _mm_set1_ps(a_rayOrigin.x);
+			const __m128 originY = _mm_set1_ps(a_rayOrigin.y);
+			const __m128 originZ = _mm_set1_ps(a_rayOrigin.z);
+			const __m128 directionX = _mm_set1_ps(a_rayDirection.x);
+			const __m128 directionY = _mm_set1_ps(a_rayDirection.y);
+			const __m128 directionZ = _mm_set1_ps(a_rayDirection.z);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 noHit = _mm_set1_ps(FLT_MAX);
+
+			// per-lane nearest hit, indices are kept as floats (exact up to 2^24 spheres)
+			__m128 nearestDistance = noHit;
+			__m128 nearestIndex = _mm_set1_ps(-1.0f);
+			__m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+			const __m128 indexStep = _mm_set1_ps(4.0f);
+
+			for (; i + 4 <= count; i += 4) {
+				const __m128 toCenterX = _mm_sub_ps(_mm_loadu_ps(a_centerX.data() + i), originX);
+				const __m128 toCenterY = _mm_sub_ps(_mm_loadu_ps(a_centerY.data() + i), originY);
+				const __m128 toCenterZ = _mm_sub_ps(_mm_loadu_ps(a_centerZ.data() + i), originZ);
+				const __m128 radius = _mm_loadu_ps(a_radius.data() + i);
+
+				const __m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCenterX, directionX), _mm_mul_ps(toCenterY, directionY)),
+					_mm_mul_ps(toCenterZ, directionZ));
+				// squared distance between the sphere center and its closest point on the ray
+				const __m128 offRayX = _mm_sub_ps(toCenterX, _mm_mul_ps(directionX, projection));
+				const __m128 offRayY = _mm_sub_ps(toCenterY, _mm_mul_ps(directionY, projection));
+				const __m128 offRayZ = _mm_sub_ps(toCenterZ, _mm_mul_ps(directionZ, projection));
+				const __m128 offRaySquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offRayX, offRayX), _mm_mul_ps(offRayY, offRayY)),
+					_mm_mul_ps(offRayZ, offRayZ));
+				const __m128 halfChordSquared = _mm_sub_ps(_mm_mul_ps(radius, radius), offRaySquared);
+
+				const __m128 isHit = _mm_and_ps(_mm_cmpge_ps(projection, zero), _mm_cmpge_ps(halfChordSquared, zero));
+				const __m128 entry = _mm_sub_ps(projection, _mm_sqrt_ps(_mm_max_ps(halfChordSquared, zero)));
+				const __m128 distance = _mm_or_ps(_mm_and_ps(isHit, entry), _mm_andnot_ps(isHit, noHit));
+
+				const __m128 isNearer = _mm_cmplt_ps(distance, nearestDistance);
+				nearestDistance = _mm_or_ps(_mm_and_ps(isNearer, distance), _mm_andnot_ps(isNearer, nearestDistance));
+				nearestIndex = _mm_or_ps(_mm_and_ps(isNearer, index), _mm_andnot_ps(isNearer, nearestIndex));
+				index = _mm_add_ps(index, indexStep);
+			}
+
+			alignas(16) float laneDistance[4];
+			alignas(16) float laneIndex[4];
+			_mm_store_ps(laneDistance, nearestDistance);
+			_mm_store_ps(laneIndex, nearestIndex);
+			for (std::size_t lane = 0; lane < 4; ++lane) {
+				if (laneIndex[lane] < 0.0f) {
+					continue;
+				}
+				const auto laneHit = static_cast<std::size_t>(laneIndex[lane]);
+				// on equal distances the lower index wins, as in a sequential scan
+				if (laneDistance[lane] < hit.distance || (laneDistance[lane] == hit.distance && laneHit < hit.index)) {
+					hit.distance = laneDistance[lane];
+					hit.index = laneHit;
+				}
+			}
+		}
+
+		for (; i < count; ++i) {
+			const float distance = GetRaySphereEntryDistance(a_rayOrigin, a_rayDirection,
+				RE::NiPoint3{ a_centerX[i], a_centerY[i], a_centerZ[i] }, a_radius[i]);
+			if (distance < hit.distance) {
+				hit.distance = distance;
+				hit.index = i;
+			}
+		}
+
+		return hit;
+	}
+
+	// Ray-capsule test, the capsule being the segment a-b swept by a_radius.
+	// The capsule is the union of a cylinder and two end spheres, so its entry distance is the nearest entry into any of them.
+	static float GetRayCapsuleEntryDistance(const RE::NiPoint3& a_rayOrigin, const RE::NiPoint3& a_rayDirection,
+											const RE::NiPoint3& a_segmentA, const RE::NiPoint3& a_segmentB, float a_radius) {
+		float nearest = FLT_MAX;
+
+		// cylinder body
+		const RE::NiPoint3 ba = a_segmentB - a_segmentA;
+		const RE::NiPoint3 oa = a_rayOrigin - a_segmentA;
+		const float baba = ba.Dot(ba);
+		const float bard = ba.Dot(a_rayDirection);
+		const float baoa = ba.Dot(oa);
+		const float a = baba - bard * bard;
+		if (a > 0.0f) {
+			const float b = baba * a_rayDirection.Dot(oa) - baoa * bard;
+			const float c = baba * oa.Dot(oa) - baoa * baoa - a_radius * a_radius * baba;
+			const float h = b * b - a * c;
+			if (h >= 0.0f) {
+				const float t = (-b - std::sqrt(h)) / a;
+				const float y = baoa + t * bard;
+				if (t >= 0.0f && y > 0.0f && y < baba) {
+					nearest = t;
+				}
+			}
+		}
+
+		// end spheres
+		for (const auto& center : { a_segmentA, a_segmentB }) {
+			const RE::NiPoint3 fromCenter = a_rayOrigin - center;
+			const float b = a_rayDirection.Dot(fromCenter);
+			const float h = b * b - (fromCenter.Dot(fromCenter) - a_radius * a_radius);
+			if (h >= 0.0f) {
+				const float t = -b - std::sqrt(h);
+				if (t >= 0.0f && t < nearest) {
+					nearest = t;
+				}
+			}
+		}
+
+		return nearest;
+	}
+
+	RayHit IntersectRayCapsules(const RE::NiPoint3& a_rayOrigin, const RE::NiPoint3& a_rayDirection,
+								std::span<const RE::NiPoint3> a_segmentA, std::span<const RE::NiPoint3> a_segmentB,
+								std::span<const float> a_radius) {
+		const std::size_t count = std::min({ a_segmentA.size(), a_segmentB.size(), a_radius.size() });
+		RayHit hit;
+		for (std::size_t i = 0; i < count; ++i) {
+			const float distance = GetRayCapsuleEntryDistance(a_rayOrigin, a_rayDirection, a_segmentA[i], a_segmentB[i], a_radius[i]);
+			if (distance < hit.distance) {
+				hit.distance = distance;
+				hit.index = i;
+			}
+		}
+		return hit;
+	}
+
 	float GetCrosshairIntersectionDistance(RE::Actor* a_actor, float a_maxScanAngle) {
         if (!a_actor) {
             return FLT_MAX;
@@ -1275,107 +2801,133 @@ namespace _ts_SKSEFunctions {
         auto playerPos = playerActor->GetPosition();
         const auto& worldTransform = playerCamera->cameraRoot->world;
         
-        // The forward vector is the third column of the rotation matrix
-        RE::NiPoint3 cameraForward = worldTransform.rotate * RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
-        cameraForward.Unitize();
-
-
-        // Strategy 1: Check if any target point (body part) is within the scan cone
-        // This works well at medium-to-long distances, also when the actor is hidden by other geometry
-        auto targetPoints = GetAllTargetPoints(a_actor);
-        float closestPointDistance = FLT_MAX;
-        
-        for (const auto& targetPoint : targetPoints) {
-            if (!targetPoint) {
-                continue;
-            }
-            
-            RE::NiPoint3 pointPos = targetPoint->world.translate;
-            float fAngleForward = _ts_SKSEFunctions::GetAngleBetweenVectors(pointPos - cameraPos, cameraForward);
-            
-            if (fabsf(fAngleForward) <= a_maxScanAngle || a_maxScanAngle <= 0.0f) {
-                float distanceToPlayer = pointPos.GetDistance(playerPos);
-                if (distanceToPlayer < closestPointDistance) {
-                    closestPointDistance = distanceToPlayer;
-                }
-            }
-        }
-        
+        // The forward vector is the third column of the rotation matrix
+        RE::NiPoint3 cameraForward = worldTransform.rotate * RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
+        cameraForward.Unitize();
+
+        float closestPointDistance = GetTargetPointScanDistance(a_actor, cameraPos, cameraForward, playerPos, a_maxScanAngle);
         if (closestPointDistance < FLT_MAX) {
             return closestPointDistance;
         }
 
-        // Strategy 2: Ray-sphere intersection with actor's bounding sphere
         // This is used as fallback when close to actor and no body parts are in cone
         auto actor3D = a_actor->Get3D();
         if (!actor3D) {
             return FLT_MAX;
         }
 
-        auto& boundingSphere = actor3D->worldBound;
-        RE::NiPoint3 sphereCenter = boundingSphere.center;
-        float sphereRadius = boundingSphere.radius;
-
-        RE::NiPoint3 toSphere = sphereCenter - cameraPos;
-        float projectionLength = toSphere.Dot(cameraForward);
-        
-        // Skip if sphere is behind camera
-        if (projectionLength < 0) {
-            return FLT_MAX;
-        }
-        
-        // Find closest point on ray to sphere center
-        RE::NiPoint3 closestPointOnRay = cameraPos + (cameraForward * projectionLength);
-        float distanceToCenter = closestPointOnRay.GetDistance(sphereCenter);
-        
-        // Check if ray intersects the bounding sphere
-        if (distanceToCenter <= sphereRadius) {
-            // Calculate actual intersection distance (entry point)
-            return (projectionLength - sqrtf(sphereRadius * sphereRadius - distanceToCenter * distanceToCenter));
-        }
-
-        return FLT_MAX;
+        return GetRaySphereEntryDistance(cameraPos, cameraForward, actor3D->worldBound.center, actor3D->worldBound.radius);
     }
 	
 /******************************************************************************************/
 
-    RE::Actor* GetCrosshairTarget(float a_maxTargetDistance, float a_maxTargetScanAngle, std::vector<RE::Actor*> a_excludeActors) {
+    RE::Actor* GetCrosshairTarget(float a_maxTargetDistance, float a_maxTargetScanAngle, std::span<RE::Actor* const> a_excludeActors) {
+        thread_local ActorFilter filter;
+        filter.ClearExcluded();
+        filter.SetFlags(ActorFilter::kRequire3D).SetMaxDistance(a_maxTargetDistance).Exclude(a_excludeActors);
+        return GetCrosshairTarget(filter, a_maxTargetScanAngle);
+    }
+
+    RE::Actor* GetCrosshairTarget(const ActorFilter& a_filter, float a_maxTargetScanAngle) {
         auto* playerActor = RE::PlayerCharacter::GetSingleton();
-        auto* processLists = RE::ProcessLists::GetSingleton();
+        auto* playerCamera = RE::PlayerCamera::GetSingleton();
 
         if (!playerActor) {
             log::error("TTE - {}: PlayerActor is null", __func__);
             return nullptr;
         }
-        if (!processLists) {
-            log::error("TTE - {}: ProcessLists is null", __func__);
+        if (!playerCamera) {
+            log::error("TTE - {}: PlayerCamera is null", __func__);
             return nullptr;
         }
 
-        RE::Actor* selectedActor = nullptr;
-        float closestDistance = a_maxTargetDistance > 0.0f ? a_maxTargetDistance : FLT_MAX;
-        
-        for (auto handle : processLists->highActorHandles) {
-            auto actor = handle.get().get();
-            if (!actor || !actor->Get3D()) {
-                continue;
+        auto cameraPos = playerCamera->cameraRoot->world.translate;
+        const auto& worldTransform = playerCamera->cameraRoot->world;
+
+        // The forward vector is the third column of the rotation matrix
+        RE::NiPoint3 cameraForward = worldTransform.rotate * RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
+        cameraForward.Unitize();
+
+        const auto snapshot = GetActorSnapshot();
+        const auto& playerPos = snapshot->playerPos;
+
+        const float maxTargetDistance = a_filter.GetMaxDistance();
+        thread_local std::vector<std::uint32_t> candidates;
+        GetSnapshotCandidates(*snapshot, playerPos, maxTargetDistance, candidates);
+
+        // Drop the rejected candidates first, so the passes below only see actors that can be selected
+        std::erase_if(candidates, [&](std::uint32_t i) {
+            return !a_filter.Accepts(*snapshot, i, snapshot->GetPosition(i).GetDistance(playerPos));
+        });
+
+        // Strategy 1: gather the target points of all candidates and cone-test them in one batch
+        thread_local std::vector<float> pointX, pointY, pointZ;
+        thread_local std::vector<std::uint32_t> pointOwner;
+        thread_local std::vector<std::uint64_t> pointMask;
+        pointX.clear();
+        pointY.clear();
+        pointZ.clear();
+        pointOwner.clear();
+        for (std::uint32_t k = 0; k < candidates.size(); ++k) {
+            for (const auto& pointPos : GetCachedTargetPointPositions(snapshot->actors[candidates[k]])) {
+                pointX.push_back(pointPos.x);
+                pointY.push_back(pointPos.y);
+                pointZ.push_back(pointPos.z);
+                pointOwner.push_back(k);
             }
-            
-            if (std::find(a_excludeActors.begin(), a_excludeActors.end(), actor) != a_excludeActors.end()) {
-                continue;
+        }
+        pointMask.resize((pointX.size() + 63) / 64);
+        ConeFilter(pointX, pointY, pointZ, cameraPos, cameraForward, a_maxTargetScanAngle <= 0.0f ? 180.0f : a_maxTargetScanAngle, pointMask);
+
+        thread_local std::vector<float> pointDistance;
+        pointDistance.assign(candidates.size(), FLT_MAX);
+        for (std::size_t word = 0; word < pointMask.size(); ++word) {
+            for (auto bits = pointMask[word]; bits != 0; bits &= bits - 1) {
+                const std::size_t p = word * 64 + std::countr_zero(bits);
+                const float distanceToPlayer = RE::NiPoint3{ pointX[p], pointY[p], pointZ[p] }.GetDistance(playerPos);
+                auto& closestPointDistance = pointDistance[pointOwner[p]];
+                if (distanceToPlayer < closestPointDistance) {
+                    closestPointDistance = distanceToPlayer;
+                }
             }
-            
-            if (a_maxTargetDistance > 0.0f && actor->GetPosition().GetDistance(playerActor->GetPosition()) > a_maxTargetDistance) {
-                continue;
+        }
+
+        // Strategy 2: candidates without a target point in the cone fall back to their bounding sphere, also in one batch
+        thread_local std::vector<float> boundX, boundY, boundZ, boundRadius;
+        thread_local std::vector<std::uint32_t> boundOwner;
+        boundX.clear();
+        boundY.clear();
+        boundZ.clear();
+        boundRadius.clear();
+        boundOwner.clear();
+
+        std::size_t selected = RayHit::kNoHit;
+        float closestDistance = maxTargetDistance > 0.0f ? maxTargetDistance : FLT_MAX;
+        for (std::uint32_t k = 0; k < candidates.size(); ++k) {
+            if (pointDistance[k] == FLT_MAX) {
+                const auto i = candidates[k];
+                boundX.push_back(snapshot->boundX[i]);
+                boundY.push_back(snapshot->boundY[i]);
+                boundZ.push_back(snapshot->boundZ[i]);
+                boundRadius.push_back(snapshot->boundRadius[i]);
+                boundOwner.push_back(k);
+            } else if (pointDistance[k] < closestDistance) {
+                closestDistance = pointDistance[k];
+                selected = k;
             }
+        }
 
-            // Check if crosshair intersects this actor
-            float intersectionDistance = GetCrosshairIntersectionDistance(actor, a_maxTargetScanAngle);
-            if (intersectionDistance < closestDistance) {
-                closestDistance = intersectionDistance;
-                selectedActor = actor;
+        const RayHit boundHit = IntersectRaySpheres(cameraPos, cameraForward, boundX, boundY, boundZ, boundRadius);
+        if (boundHit.index != RayHit::kNoHit) {
+            const auto k = boundOwner[boundHit.index];
+            // on a tie the candidate that comes first wins, as when testing them one by one
+            if (boundHit.distance < closestDistance || (boundHit.distance == closestDistance && selected != RayHit::kNoHit && k < selected)) {
+                closestDistance = boundHit.distance;
+                selected = k;
             }
         }
+
+        RE::Actor* selectedActor = selected != RayHit::kNoHit ? snapshot->actors[candidates[selected]] : nullptr;
 /*
 // Experimentation for using Havok raycast against actual collision geometry:
 // A single raycast would be sufficient to determine if the crosshair is intersecting an actor's collision mesh.
@@ -1459,31 +3011,121 @@ log::info("{}: Raycast hit something",__FUNCTION__);
 
 /******************************************************************************************/
 
-    RE::Actor* FindClosestActorInCameraDirection(
-            float a_angleTolerance, 
-            float a_maxDistance,
-			bool a_excludeAllies,
-            const std::vector<RE::Actor*>& excludeActors) {
+	CrosshairTracker::CrosshairTracker(const Settings& a_settings) :
+		_settings(a_settings)
+	{}
+
+	void CrosshairTracker::Reset() {
+		_target.reset();
+		_targetDistance = FLT_MAX;
+		_hasScanned = false;
+	}
+
+	RE::Actor* CrosshairTracker::GetTarget() const {
+		return _target.get().get();
+	}
+
+	RE::Actor* CrosshairTracker::Update(float a_maxTargetDistance, float a_maxTargetScanAngle, std::span<RE::Actor* const> a_excludeActors) {
+		thread_local ActorFilter filter;
+		filter.ClearExcluded();
+		filter.SetFlags(ActorFilter::kRequire3D).SetMaxDistance(a_maxTargetDistance).Exclude(a_excludeActors);
+		return Update(filter, a_maxTargetScanAngle);
+	}
+
+	// returns the crosshair intersection distance of a_actor if it still passes a_filter, FLT_MAX otherwise
+	static float GetTrackedTargetDistance(RE::Actor* a_actor, const ActorFilter& a_filter, float a_maxTargetScanAngle,
+										  RE::Actor* a_playerActor) {
+		if (!a_actor || a_filter.IsExcluded(a_actor) || !a_filter.AcceptsFlags(GetActorSnapshotFlags(a_actor, a_playerActor)) ||
+			!a_filter.IsInRange(a_actor->GetPosition().GetDistance(a_playerActor->GetPosition()))) {
+			return FLT_MAX;
+		}
+
+		const float distance = GetCrosshairIntersectionDistance(a_actor, a_maxTargetScanAngle);
+		const float maxTargetDistance = a_filter.GetMaxDistance();
+		return maxTargetDistance > 0.0f && distance >= maxTargetDistance ? FLT_MAX : distance;
+	}
+
+	RE::Actor* CrosshairTracker::Update(const ActorFilter& a_filter, float a_maxTargetScanAngle) {
+		auto* playerActor = RE::PlayerCharacter::GetSingleton();
+		auto* playerCamera = RE::PlayerCamera::GetSingleton();
+		if (!playerActor || !playerCamera || !playerCamera->cameraRoot) {
+			return nullptr;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		++_stats.updates;
+
+		const auto& worldTransform = playerCamera->cameraRoot->world;
+		const auto cameraPos = worldTransform.translate;
+		RE::NiPoint3 cameraForward = worldTransform.rotate * RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
+		cameraForward.Unitize();
+
+		const std::uint32_t now = RE::GetDurationOfApplicationRunTime();
+		const bool cameraMoved = !_hasScanned ||
+			cameraPos.GetDistance(_scanCameraPos) > _settings.positionThreshold ||
+			cameraForward.Dot(_scanCameraForward) < std::cos(_settings.rotationThreshold * PI / 180.0f);
+		const bool intervalElapsed = now - _scanTime >= _settings.rescanInterval;
+
+		RE::Actor* target = GetTarget();
+		_targetDistance = GetTrackedTargetDistance(target, a_filter, a_maxTargetScanAngle, playerActor);
+		if (_targetDistance == FLT_MAX) {
+			target = nullptr;
+		}
+
+		if (!cameraMoved && !intervalElapsed && (target || !_target)) {
+			// the camera is (nearly) where it was at the last scan and the target is still valid, so keep it
+			++_stats.hits;
+			_stats.revalidateTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			return target;
+		}
+
+		++_stats.rescans;
+		_hasScanned = true;
+		_scanCameraPos = cameraPos;
+		_scanCameraForward = cameraForward;
+		_scanTime = now;
+
+		RE::Actor* candidate = GetCrosshairTarget(a_filter, a_maxTargetScanAngle);
+		if (candidate != target) {
+			const float candidateDistance = candidate ? GetCrosshairIntersectionDistance(candidate, a_maxTargetScanAngle) : FLT_MAX;
+			// hysteresis: a valid target is only replaced by one that is clearly closer, so nearby targets don't flicker
+			if (!target || (candidate && candidateDistance < _targetDistance * (1.0f - _settings.hysteresis))) {
+				if (target || candidate) {
+					++_stats.targetChanges;
+				}
+				target = candidate;
+				_targetDistance = candidateDistance;
+			}
+		}
+
+		_target = target ? target->GetHandle() : RE::ActorHandle();
+		_stats.rescanTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		return target;
+	}
+
+/******************************************************************************************/
+
+	// Visits all actors in the camera cone that pass a_filter.
+	// a_func is called with the actor, its distance to the player and its direction from the camera.
+	template <class Func>
+	static bool ForEachActorInCameraDirection(
+			const ActorFilter& a_filter,
+			float a_angleTolerance,
+			Func&& a_func) {
 
         auto* playerActor = RE::PlayerCharacter::GetSingleton();
-        auto* processLists = RE::ProcessLists::GetSingleton();
         auto* playerCamera = RE::PlayerCamera::GetSingleton();
 
         if (!playerActor) {
             spdlog::error("_ts_SKSEFunctions - {}: PlayerActor is null", __func__);
-            return nullptr;
-        }
-        if (!processLists) {
-            spdlog::error("_ts_SKSEFunctions - {}: ProcessLists is null", __func__);
-            return nullptr;
+            return false;
         }
         if (!playerCamera) {
             spdlog::error("_ts_SKSEFunctions - {}: PlayerCamera is null", __func__);
-            return nullptr;
+            return false;
         }
 
         auto cameraPos = playerCamera->cameraRoot->world.translate;
-        auto playerPos = playerActor->GetPosition();
 
         auto root = playerCamera->cameraRoot;
         const auto& worldTransform = root->world; // RE::NiTransform
@@ -1491,34 +3133,147 @@ log::info("{}: Raycast hit something",__FUNCTION__);
         // The forward vector is the third column of the rotation matrix
         RE::NiPoint3 cameraForward = worldTransform.rotate * RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
 
+        const auto snapshot = GetActorSnapshot();
+        const auto& playerPos = snapshot->playerPos;
+
+        thread_local std::vector<std::uint32_t> candidates;
+        GetSnapshotCandidates(*snapshot, playerPos, a_filter.GetMaxDistance(), candidates);
+
+        // test all candidates against the camera cone in one batch
+        thread_local std::vector<float> candidateX, candidateY, candidateZ;
+        thread_local std::vector<std::uint64_t> coneMask;
+        candidateX.resize(candidates.size());
+        candidateY.resize(candidates.size());
+        candidateZ.resize(candidates.size());
+        for (std::size_t j = 0; j < candidates.size(); ++j) {
+            candidateX[j] = snapshot->posX[candidates[j]];
+            candidateY[j] = snapshot->posY[candidates[j]];
+            candidateZ[j] = snapshot->posZ[candidates[j]];
+        }
+        coneMask.resize((candidates.size() + 63) / 64);
+        ConeFilter(candidateX, candidateY, candidateZ, cameraPos, cameraForward, a_angleTolerance, coneMask);
+
+        for (std::size_t j = 0; j < candidates.size(); ++j) {
+            if (((coneMask[j / 64] >> (j % 64)) & 1) == 0) {
+                continue;
+            }
+
+            const auto i = candidates[j];
+            const RE::NiPoint3 actorPos = snapshot->GetPosition(i);
+            const float distance = actorPos.GetDistance(playerPos);
+            if (!a_filter.Accepts(*snapshot, i, distance)) {
+                continue;
+            }
+
+            a_func(snapshot->actors[i], distance, actorPos - cameraPos, cameraForward);
+        }
+
+        return true;
+    }
+
+	// filter matching the parameters of the camera-direction searches
+	static const ActorFilter& GetCameraDirectionFilter(float a_maxDistance, bool a_excludeAllies, std::span<RE::Actor* const> a_excludeActors) {
+		thread_local ActorFilter filter;
+		filter.ClearExcluded();
+		filter.SetFlags(static_cast<std::uint8_t>(ActorFilter::kRequire3D | ActorFilter::kExcludeDead | (a_excludeAllies ? ActorFilter::kExcludeAllies : ActorFilter::kNone)))
+			.SetMaxDistance(a_maxDistance)
+			.Exclude(a_excludeActors);
+		return filter;
+	}
+
+    RE::Actor* FindClosestActorInCameraDirection(
+            float a_angleTolerance, 
+            float a_maxDistance,
+			bool a_excludeAllies,
+            std::span<RE::Actor* const> excludeActors) {
+
+        return FindClosestActorInCameraDirection(GetCameraDirectionFilter(a_maxDistance, a_excludeAllies, excludeActors), a_angleTolerance);
+    }
+
+    RE::Actor* FindClosestActorInCameraDirection(const ActorFilter& a_filter, float a_angleTolerance) {
         RE::Actor* selectedActor = nullptr;
-        for (auto handle : processLists->highActorHandles) {
-            auto actor = handle.get().get();
-            if (actor
-                && std::find(excludeActors.begin(), excludeActors.end(), actor) == excludeActors.end() 
-                && actor->Get3D() 
-                && !actor->IsDead()
-				&& !(a_excludeAllies && actor->GetFactionReaction(playerActor) == RE::FIGHT_REACTION::kAlly)
-                && (a_maxDistance <= 0.0f || actor->GetPosition().GetDistance(playerPos) <= a_maxDistance)) {
-
-                float fAngle = GetAngleBetweenVectors(actor->GetPosition() - cameraPos, cameraForward);
-
-                if (fAngle <= a_angleTolerance) {
-                    if (selectedActor) {
-spdlog::info("_ts_SKSEFunctions - {}: Checking actor: {}, angle = {}, distance = {}", __func__, actor->GetName(), fAngle, actor->GetPosition().GetDistance(playerPos));
-                        if (actor->GetPosition().GetDistance(playerPos) < selectedActor->GetPosition().GetDistance(playerPos)) {
-spdlog::info("_ts_SKSEFunctions - {}: New selected actor: {}, angle = {}, distance = {}", __func__, actor->GetName(), fAngle, actor->GetPosition().GetDistance(playerPos));
-                            selectedActor = actor;
-                        }
-                    } else {
-spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, distance = {}", __func__, actor->GetName(), fAngle, actor->GetPosition().GetDistance(playerPos));
-                        selectedActor = actor;
-                    }
+        float selectedDistance = FLT_MAX;
+        ForEachActorInCameraDirection(a_filter, a_angleTolerance,
+            [&](RE::Actor* a_actor, float a_distance, const RE::NiPoint3&, const RE::NiPoint3&) {
+                if (a_distance < selectedDistance) {
+                    selectedActor = a_actor;
+                    selectedDistance = a_distance;
                 }
+            });
+
+        return selectedActor;
+    }
+
+    std::vector<RE::Actor*> FindActorsInCameraDirection(
+            std::size_t a_count,
+            float a_angleTolerance,
+            float a_maxDistance,
+            bool a_excludeAllies,
+            std::span<RE::Actor* const> excludeActors,
+            const TargetScore& a_score) {
+
+        return FindActorsInCameraDirection(a_count, GetCameraDirectionFilter(a_maxDistance, a_excludeAllies, excludeActors), a_angleTolerance, a_score);
+    }
+
+    std::vector<RE::Actor*> FindActorsInCameraDirection(
+            std::size_t a_count,
+            const ActorFilter& a_filter,
+            float a_angleTolerance,
+            const TargetScore& a_score) {
+
+        std::vector<RE::Actor*> result;
+        if (a_count == 0) {
+            return result;
+        }
+
+        struct Candidate
+        {
+            float score;
+            std::uint32_t order;  // visiting order, so that ties keep the actor found first
+            RE::Actor* actor;
+
+            bool operator<(const Candidate& a_rhs) const {
+                return score < a_rhs.score || (score == a_rhs.score && order < a_rhs.order);
             }
+        };
+
+        // weighted scores compare distance and angle relative to the search range
+        const float distanceRange = a_filter.GetMaxDistance() > 0.0f ? a_filter.GetMaxDistance() : TargetScore::kDefaultDistanceRange;
+        const float angleRange = std::clamp(a_angleTolerance, 1.0f, 180.0f);
+
+        // bounded max-heap: the worst of the best a_count candidates is on top
+        thread_local std::vector<Candidate> heap;
+        heap.clear();
+        std::uint32_t order = 0;
+
+        ForEachActorInCameraDirection(a_filter, a_angleTolerance,
+            [&](RE::Actor* a_actor, float a_distance, const RE::NiPoint3& a_direction, const RE::NiPoint3& a_cameraForward) {
+                float score = a_distance;
+                if (a_score.mode != TargetScore::Mode::kDistance) {
+                    const float angle = GetAngleBetweenVectors(a_direction, a_cameraForward);
+                    score = a_score.mode == TargetScore::Mode::kAngle ?
+                        angle :
+                        a_score.distanceWeight * (a_distance / distanceRange) + a_score.angleWeight * (angle / angleRange);
+                }
+
+                const Candidate candidate{ score, order++, a_actor };
+                if (heap.size() < a_count) {
+                    heap.push_back(candidate);
+                    std::push_heap(heap.begin(), heap.end());
+                } else if (candidate < heap.front()) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = candidate;
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            });
+
+        std::sort_heap(heap.begin(), heap.end());
+        result.reserve(heap.size());
+        for (const auto& candidate : heap) {
+            result.push_back(candidate.actor);
         }
 
-        return selectedActor;
+        return result;
     }
 
 /******************************************************************************************/
@@ -1555,8 +3310,118 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 		return GetCell(cellX, cellY, a_worldspace, a_loadedFromDisk);
     }
 
-    RE::TESObjectCELL* GetCell(std::int16_t a_cellX, std::int16_t a_cellY, RE::TESWorldSpace* a_worldspace, bool& a_loadedFromDisk) {
+    // Direct-mapped cache in front of worldspace->cellMap, one per thread so lookups don't need a lock.
+    // Slots are tagged with the worldspace and cell index. The cached pointers are never dereferenced by the cache:
+    // they are dropped before the game can free the cells, as InvalidateCellCache() is called when the player changes
+    // cell (the cell buffers are purged on cell changes) and when a game is loaded.
+    // Bumping the generation makes every thread flush its cache on its next lookup.
+    struct CellCacheSlot
+    {
+        RE::TESWorldSpace* worldspace = nullptr;
+        RE::TESObjectCELL* cell = nullptr;
+        std::int16_t cellX = 0;
+        std::int16_t cellY = 0;
+    };
+
+    constexpr std::size_t kCellCacheSize = 256;  // power of two
+    static std::atomic<std::uint32_t> g_cellCacheGeneration{ 0 };
+
+    struct CellCache
+    {
+        std::array<CellCacheSlot, kCellCacheSize> slots{};
+        RE::TESWorldSpace* worldspace = nullptr;
+        std::uint32_t generation = 0;
+    };
+
+    class CellCacheEventSink :
+        public RE::BSTEventSink<RE::BGSActorCellEvent>,
+        public RE::BSTEventSink<RE::TESLoadGameEvent>
+    {
+    public:
+        static CellCacheEventSink* GetSingleton() {
+            static CellCacheEventSink singleton;
+            return &singleton;
+        }
+
+        // returns false if the player doesn't exist yet, so registering is retried on the next lookup
+        static bool Register() {
+            static std::atomic<bool> registered{ false };
+            if (registered.load(std::memory_order_acquire)) {
+                return true;
+            }
+
+            static std::mutex lock;
+            std::lock_guard guard(lock);
+            auto* player = RE::PlayerCharacter::GetSingleton();
+            auto* eventSource = RE::ScriptEventSourceHolder::GetSingleton();
+            if (!registered.load(std::memory_order_relaxed) && player && eventSource) {
+                player->AsBGSActorCellEventSource()->AddEventSink(GetSingleton());
+                eventSource->AddEventSink<RE::TESLoadGameEvent>(GetSingleton());
+                registered.store(true, std::memory_order_release);
+            }
+            return registered.load(std::memory_order_relaxed);
+        }
+
+        RE::BSEventNotifyControl ProcessEvent(const RE::BGSActorCellEvent*, RE::BSTEventSource<RE::BGSActorCellEvent>*) override {
+            InvalidateCellCache();
+            return RE::BSEventNotifyControl::kContinue;
+        }
+
+        RE::BSEventNotifyControl ProcessEvent(const RE::TESLoadGameEvent*, RE::BSTEventSource<RE::TESLoadGameEvent>*) override {
+            InvalidateCellCache();
+            return RE::BSEventNotifyControl::kContinue;
+        }
+    };
+
+    // returns nullptr if the cache can't be used yet, because its invalidation events aren't registered
+    static CellCacheSlot* GetCellCacheSlot(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) {
+        if (!CellCacheEventSink::Register()) {
+            return nullptr;
+        }
+
+        thread_local CellCache cache;
+        const auto generation = g_cellCacheGeneration.load(std::memory_order_acquire);
+        if (cache.worldspace != a_worldspace || cache.generation != generation) {
+            cache.slots.fill({});
+            cache.worldspace = a_worldspace;
+            cache.generation = generation;
+        }
+
+        const auto hash = (static_cast<std::uint32_t>(static_cast<std::uint16_t>(a_cellX)) * 0x9E3779B1u) ^
+            (static_cast<std::uint32_t>(static_cast<std::uint16_t>(a_cellY)) * 0x85EBCA77u);
+        return &cache.slots[(hash ^ (hash >> 16)) & (kCellCacheSize - 1)];
+    }
+
+    // returns the cell if it is in the cache or in worldspace->cellMap, without loading it
+    static RE::TESObjectCELL* FindResidentCell(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) {
+        auto* slot = GetCellCacheSlot(a_worldspace, a_cellX, a_cellY);
+        if (slot && slot->cell && slot->worldspace == a_worldspace && slot->cellX == a_cellX && slot->cellY == a_cellY) {
+            return slot->cell;
+        }
+
         RE::TESObjectCELL* cell = nullptr;
+        const auto& map = a_worldspace->cellMap;
+        const auto it = map.find(RE::CellID(a_cellY, a_cellX));
+        if (it != map.end()) {
+            cell = it->second;
+        }
+        if (slot) {
+            *slot = { a_worldspace, cell, a_cellX, a_cellY };
+        }
+        return cell;
+    }
+
+    static void StoreCellInCache(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY, RE::TESObjectCELL* a_cell) {
+        if (auto* slot = GetCellCacheSlot(a_worldspace, a_cellX, a_cellY)) {
+            *slot = { a_worldspace, a_cell, a_cellX, a_cellY };
+        }
+    }
+
+    void InvalidateCellCache() {
+        g_cellCacheGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+    RE::TESObjectCELL* GetCell(std::int16_t a_cellX, std::int16_t a_cellY, RE::TESWorldSpace* a_worldspace, bool& a_loadedFromDisk) {
         a_loadedFromDisk = false;
         
         auto* tes = RE::TES::GetSingleton();
@@ -1569,23 +3434,64 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
             log::warn("{}: Worldspace parameter is null", __FUNCTION__);
             return nullptr;
         }
-        RE::CellID cellID(a_cellY, a_cellX);
-        const auto& map = a_worldspace->cellMap;
-        const auto it = map.find(cellID);
-        if (it != map.end()) {
-            cell = it->second;
-        }
+        RE::TESObjectCELL* cell = FindResidentCell(a_worldspace, a_cellX, a_cellY);
         // If not in map, load it using TESWorldSpace_LoadCell
         if (!cell) {
             TES_CancelMasterFileLoads(tes);
             cell = TESWorldSpace_LoadCell(a_worldspace, a_cellX, a_cellY);
             TES_ResumeMasterFileLoads(tes);
             a_loadedFromDisk = true;
+            StoreCellInCache(a_worldspace, a_cellX, a_cellY, cell);
         }
 
         return cell;
     }
 
+    std::size_t GetCells(std::span<const RE::CellID> a_cellIDs, RE::TESWorldSpace* a_worldspace, std::span<RE::TESObjectCELL*> a_outCells) {
+        const std::size_t count = std::min(a_cellIDs.size(), a_outCells.size());
+        std::fill_n(a_outCells.begin(), count, nullptr);
+
+        auto* tes = RE::TES::GetSingleton();
+        if (!tes || !a_worldspace) {
+            log::warn("{}: Cannot access TES singleton or worldspace", __FUNCTION__);
+            return 0;
+        }
+
+        bool hasMisses = false;
+        for (std::size_t i = 0; i < count; ++i) {
+            a_outCells[i] = FindResidentCell(a_worldspace, a_cellIDs[i].x, a_cellIDs[i].y);
+            hasMisses |= a_outCells[i] == nullptr;
+        }
+        if (!hasMisses) {
+            return 0;
+        }
+
+        // one cancel/resume pair for all cells that have to be loaded, each distinct cell is only loaded once
+        std::size_t loadedCount = 0;
+        std::unordered_map<std::uint32_t, RE::TESObjectCELL*> attempted;
+        TES_CancelMasterFileLoads(tes);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (a_outCells[i]) {
+                continue;
+            }
+
+            const std::uint32_t key = (static_cast<std::uint32_t>(static_cast<std::uint16_t>(a_cellIDs[i].x)) << 16) |
+                static_cast<std::uint16_t>(a_cellIDs[i].y);
+            auto [it, inserted] = attempted.try_emplace(key, nullptr);
+            if (inserted) {
+                it->second = TESWorldSpace_LoadCell(a_worldspace, a_cellIDs[i].x, a_cellIDs[i].y);
+                StoreCellInCache(a_worldspace, a_cellIDs[i].x, a_cellIDs[i].y, it->second);
+                if (it->second) {
+                    loadedCount++;
+                }
+            }
+            a_outCells[i] = it->second;
+        }
+        TES_ResumeMasterFileLoads(tes);
+
+        return loadedCount;
+    }
+
 	void LoadCellGrid(std::int16_t a_centerCellX, std::int16_t a_centerCellY, RE::TESWorldSpace* a_worldspace, int a_sizeX, int a_sizeY) {
         auto* tes = RE::TES::GetSingleton();
         if (!tes) {
@@ -1626,7 +3532,218 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 	}
 
 /******************************************************************************************/
-	void UpdateTESGridCells(std::int32_t a_centerX, std::int32_t a_centerY)
+
+	// default loader of the prefetcher, the loads of a frame are done between one cancel/resume pair
+	class GameCellLoader : public CellPrefetcher::ICellLoader
+	{
+	public:
+		bool IsLoaded(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) override {
+			const auto& map = a_worldspace->cellMap;
+			const auto it = map.find(RE::CellID(a_cellY, a_cellX));
+			return it != map.end() && it->second;
+		}
+
+		bool Load(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) override {
+			return TESWorldSpace_LoadCell(a_worldspace, a_cellX, a_cellY) != nullptr;
+		}
+
+		void BeginLoads() override {
+			_tes = RE::TES::GetSingleton();
+			if (_tes) {
+				TES_CancelMasterFileLoads(_tes);
+			}
+		}
+
+		void EndLoads() override {
+			if (_tes) {
+				TES_ResumeMasterFileLoads(_tes);
+				_tes = nullptr;
+			}
+		}
+
+	private:
+		RE::TES* _tes = nullptr;
+	};
+
+	CellPrefetcher::CellPrefetcher() :
+		_loads(std::make_shared<GameCellLoader>())
+	{
+		// the cells loaded before may be purged by the load, and the movement history belongs to the old game
+		AddLoadGameCallback([]() { GetSingleton()->Clear(); });
+	}
+
+	CellPrefetcher* CellPrefetcher::GetSingleton() {
+		static CellPrefetcher singleton;
+		return &singleton;
+	}
+
+	void CellPrefetcher::SetLoader(std::unique_ptr<ICellLoader> a_loader) {
+		if (a_loader) {
+			_loads.SetLoader(std::move(a_loader));
+		} else {
+			_loads.SetLoader(std::make_shared<GameCellLoader>());
+		}
+	}
+
+	void CellPrefetcher::ResetMovement() {
+		_hasLastPosition = false;
+		_hasLastCell = false;
+	}
+
+	void CellPrefetcher::Clear() {
+		{
+			std::lock_guard lock(_lock);
+			ResetMovement();
+		}
+		_loads.Reset();
+	}
+
+	CellPrefetcher::Stats CellPrefetcher::GetStats() const {
+		return _loads.GetStats();
+	}
+
+	void CellPrefetcher::ResetStats() {
+		_loads.ResetStats();
+	}
+
+	void CellPrefetcher::Predict(RE::TESWorldSpace* a_worldspace, const RE::NiPoint3& a_position, const RE::NiPoint3& a_velocity,
+								 const RE::NiPoint3& a_heading) {
+		if (!a_worldspace) {
+			return;
+		}
+
+		const Settings settings = _settings;
+		// predictions are redone every frame, requests that weren't loaded in time are dropped
+		_loads.SetRequests([&](CellLoadQueue<RE::TESWorldSpace>::Builder& a_requests) {
+			const float rawSpeed = std::sqrt(a_velocity.x * a_velocity.x + a_velocity.y * a_velocity.y);
+			if (rawSpeed < settings.minSpeed || !std::isfinite(rawSpeed)) {
+				return;
+			}
+			const float speed = std::min(rawSpeed, settings.maxSpeed);
+
+			// the movement direction, and the camera heading at the same speed, as the player is likely to turn towards it
+			std::array<RE::NiPoint2, 2> directions{ RE::NiPoint2{ a_velocity.x / rawSpeed, a_velocity.y / rawSpeed } };
+			std::size_t directionCount = 1;
+			const float headingLength = std::sqrt(a_heading.x * a_heading.x + a_heading.y * a_heading.y);
+			if (headingLength > 0.0f) {
+				directions[directionCount++] = { a_heading.x / headingLength, a_heading.y / headingLength };
+			}
+
+			// one point per half cell of travel, its cell (and the ones around it) gets the travel time as priority.
+			// At high speeds the step grows instead, so the number of points stays bounded
+			const std::size_t maxPoints = std::max<std::size_t>(settings.maxPredictionPoints, 1);
+			const float timeStep = std::max(kCellSize * 0.5f / speed, settings.lookAheadTime / static_cast<float>(maxPoints));
+			const RE::FormID worldspaceID = a_worldspace->GetFormID();
+			for (std::size_t d = 0; d < directionCount; ++d) {
+				// the heading is a guess, so its cells rank after the ones on the current course
+				const float penalty = d == 0 ? 0.0f : settings.lookAheadTime * 0.5f;
+				for (std::size_t point = 1; point <= maxPoints; ++point) {
+					const float time = timeStep * static_cast<float>(point);
+					if (time > settings.lookAheadTime) {
+						break;
+					}
+					const float x = a_position.x + directions[d].x * speed * time;
+					const float y = a_position.y + directions[d].y * speed * time;
+					const auto cellX = static_cast<std::int32_t>(std::floor(x / kCellSize));
+					const auto cellY = static_cast<std::int32_t>(std::floor(y / kCellSize));
+					for (std::int32_t dy = -settings.radius; dy <= settings.radius; ++dy) {
+						for (std::int32_t dx = -settings.radius; dx <= settings.radius; ++dx) {
+							const std::int32_t requestX = cellX + dx;
+							const std::int32_t requestY = cellY + dy;
+							if (requestX < INT16_MIN || requestX > INT16_MAX || requestY < INT16_MIN || requestY > INT16_MAX) {
+								continue;
+							}
+							const float ring = static_cast<float>(std::max(std::abs(dx), std::abs(dy)));
+							a_requests.Add(a_worldspace, GetExteriorCellKey(worldspaceID, requestX, requestY), static_cast<std::int16_t>(requestX),
+								static_cast<std::int16_t>(requestY), time + penalty + ring * timeStep);
+						}
+					}
+				}
+			}
+		}, settings.maxQueueSize);
+	}
+
+	std::size_t CellPrefetcher::ProcessQueue() {
+		return _loads.Process(_settings.frameBudget_us);
+	}
+
+	void CellPrefetcher::NotifyCellEntered(RE::TESWorldSpace* a_worldspace, std::int16_t a_cellX, std::int16_t a_cellY) {
+		if (!a_worldspace) {
+			return;
+		}
+
+		const auto key = GetExteriorCellKey(a_worldspace->GetFormID(), a_cellX, a_cellY);
+		{
+			std::lock_guard lock(_lock);
+			if (_hasLastCell && key == _lastCell) {
+				return;
+			}
+			_lastCell = key;
+			_hasLastCell = true;
+		}
+		_loads.NotifyCellEntered(key);
+	}
+
+	void CellPrefetcher::Update() {
+		auto* playerActor = RE::PlayerCharacter::GetSingleton();
+		auto* playerCamera = RE::PlayerCamera::GetSingleton();
+		auto* tes = RE::TES::GetSingleton();
+		auto* worldspace = tes ? tes->GetRuntimeData2().worldSpace : nullptr;
+		if (!playerActor || !worldspace) {
+			return;
+		}
+
+		// interiors have no cell grid to prefetch, and leaving one is a discontinuity like any other
+		auto* parentCell = playerActor->GetParentCell();
+		if (!parentCell || parentCell->IsInteriorCell()) {
+			Clear();
+			return;
+		}
+
+		// the player's position is the mount's position while riding, so the velocity covers mounts as well
+		const auto position = playerActor->GetPosition();
+		const std::uint32_t now = RE::GetDurationOfApplicationRunTime();
+		RE::NiPoint3 velocity;
+		bool discontinuity = false;
+		{
+			std::lock_guard lock(_lock);
+			if (_hasLastPosition && _lastWorldspace != worldspace->GetFormID()) {
+				discontinuity = true;
+			} else if (_hasLastPosition && now != _lastUpdate) {
+				velocity = (position - _lastPosition) * (1000.0f / static_cast<float>(now - _lastUpdate));
+			}
+			// a fast travel, coc or load door moves the player further than any movement could, drop the history
+			// instead of predicting along the jump
+			if (velocity.Length() > _settings.maxSpeed) {
+				velocity = RE::NiPoint3();
+				discontinuity = true;
+			}
+			if (discontinuity) {
+				ResetMovement();
+			}
+			_lastPosition = position;
+			_lastUpdate = now;
+			_lastWorldspace = worldspace->GetFormID();
+			_hasLastPosition = true;
+		}
+		// the cells prefetched before the jump may be purged by now, don't count them as hits
+		if (discontinuity) {
+			_loads.Reset();
+		}
+
+		RE::NiPoint3 heading;
+		if (playerCamera && playerCamera->cameraRoot) {
+			heading = playerCamera->cameraRoot->world.rotate * RE::NiPoint3{ 0.0f, 1.0f, 0.0f };
+		}
+
+		NotifyCellEntered(worldspace, static_cast<std::int16_t>(std::floor(position.x / kCellSize)),
+			static_cast<std::int16_t>(std::floor(position.y / kCellSize)));
+		Predict(worldspace, position, velocity, heading);
+		ProcessQueue();
+	}
+
+/******************************************************************************************/
+	void UpdateTESGridCells(std::int32_t a_centerX, std::int32_t a_centerY, bool a_incremental)
 	{
 		auto* tes = RE::TES::GetSingleton();
 		if (!tes) {
@@ -1640,10 +3757,10 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 			return;
 		}
 		
-		UpdateTESGridCells(gridCells, a_centerX, a_centerY);
+		UpdateTESGridCells(gridCells, a_centerX, a_centerY, a_incremental);
 	}
 
-	void UpdateTESGridCells(RE::GridCellArray* a_gridCells, std::int32_t a_centerX, std::int32_t a_centerY)
+	void UpdateTESGridCells(RE::GridCellArray* a_gridCells, std::int32_t a_centerX, std::int32_t a_centerY, bool a_incremental)
 	{
 		auto perfStart = std::chrono::high_resolution_clock::now();
 		
@@ -1653,7 +3770,7 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 			return;
 		}
 		
-		auto* gridCells = tes->gridCells;
+		auto* gridCells = a_gridCells;
 		if (!gridCells) {
 			log::error("{}: GridCells not available", __FUNCTION__);
 			return;
@@ -1671,17 +3788,26 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 		const std::uint32_t gridSize = gridCells->length; // Should be 5
 		const std::int32_t halfGrid = gridSize / 2;       // Should be 2
 		
-		// Update world center position
+		// Update world center position, the height is taken from the heightfield cache if its tile is resident
 		gridCells->worldCenter.x = static_cast<float>(a_centerX * CELL_SIZE);
 		gridCells->worldCenter.y = static_cast<float>(a_centerY * CELL_SIZE);
-		gridCells->worldCenter.z = GetLandHeight(gridCells->worldCenter.x, gridCells->worldCenter.y, 0.0f);
+		const auto cachedHeight = HeightfieldCache::GetSingleton()->FindHeight(worldspace, gridCells->worldCenter.x, gridCells->worldCenter.y, false);
+		gridCells->worldCenter.z = cachedHeight ? *cachedHeight : GetLandHeight(gridCells->worldCenter.x, gridCells->worldCenter.y, 0.0f);
 		
 		log::info("{}: Updated world center to ({:.1f}, {:.1f}, {:.1f})", 
 				__FUNCTION__, gridCells->worldCenter.x, gridCells->worldCenter.y, gridCells->worldCenter.z);
 		
+		// In incremental mode the cells of the previous grid that are still inside the new one are moved to their new slot,
+		// so recentering by one cell only resolves the newly exposed row/column (5 instead of 25 cells)
+		const std::int32_t shiftX = a_centerX - tes->currentGridX;
+		const std::int32_t shiftY = a_centerY - tes->currentGridY;
+		thread_local std::vector<RE::TESObjectCELL*> previousCells;
+		previousCells.assign(gridCells->cells, gridCells->cells + static_cast<std::size_t>(gridSize) * gridSize);
+
 		// Load and populate all 25 cells in the 5x5 grid
 		int loadedCount = 0;
 		int alreadyLoadedCount = 0;
+		int reusedCount = 0;
 		int failedCount = 0;
 		
 		auto loadStart = std::chrono::high_resolution_clock::now();
@@ -1691,14 +3817,29 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 				// Calculate world cell coordinates for this grid position
 				std::int32_t worldCellX = a_centerX - halfGrid + gridX;
 				std::int32_t worldCellY = a_centerY - halfGrid + gridY;
-				
+				// Calculate array index: cells[(x * length) + y]
+				std::uint32_t arrayIndex = (gridX * gridSize) + gridY;
+
+				if (a_incremental) {
+					const std::int32_t previousX = static_cast<std::int32_t>(gridX) + shiftX;
+					const std::int32_t previousY = static_cast<std::int32_t>(gridY) + shiftY;
+					if (previousX >= 0 && previousX < static_cast<std::int32_t>(gridSize) && previousY >= 0 && previousY < static_cast<std::int32_t>(gridSize)) {
+						auto* previousCell = previousCells[(previousX * gridSize) + previousY];
+						const auto* coords = previousCell ? previousCell->GetCoordinates() : nullptr;
+						// only trust the slot if the cell really is the expected one
+						if (coords && coords->cellX == worldCellX && coords->cellY == worldCellY) {
+							gridCells->cells[arrayIndex] = previousCell;
+							reusedCount++;
+							continue;
+						}
+					}
+				}
+
 				// Load cell (from disk if needed)
 				bool loadedFromDisk = false;
 				RE::TESObjectCELL* cell = _ts_SKSEFunctions::GetCell(worldCellX, worldCellY, worldspace, loadedFromDisk);
 				
 				if (cell) {
-					// Calculate array index: cells[(x * length) + y]
-					std::uint32_t arrayIndex = (gridX * gridSize) + gridY;
 					gridCells->cells[arrayIndex] = cell;
 					
 					if (loadedFromDisk) {
@@ -1723,8 +3864,8 @@ spdlog::info("_ts_SKSEFunctions - {}: First selected actor {}: angle = {}, dista
 		tes->currentGridX = a_centerX;
 		tes->currentGridY = a_centerY;
 		
-		log::info("{}: Grid population complete: {} newly loaded, {} already loaded, {} failed", 
-				__FUNCTION__, loadedCount, alreadyLoadedCount, failedCount);
+		log::info("{}: Grid population complete: {} newly loaded, {} already loaded, {} reused, {} failed", 
+				__FUNCTION__, loadedCount, alreadyLoadedCount, reusedCount, failedCount);
 		log::info("{}: Cell loading took {:.3f} ms", __FUNCTION__, loadDuration / 1000.0);
 		
 		// Verify center cell